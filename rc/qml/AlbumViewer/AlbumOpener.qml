@@ -147,7 +147,12 @@ Item {
         animator.restart();
     }
 
-    onAlbumChanged: openFraction = (!album || album.closed || showClosed ? 0 : 1)
+    onAlbumChanged: {
+        // an open album shows its pages, so they have to be laid out
+        if (album && !album.closed)
+            album.load();
+        openFraction = (!album || album.closed || showClosed ? 0 : 1);
+    }
 
     Connections {
         target: album
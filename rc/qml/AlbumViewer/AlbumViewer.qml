@@ -72,6 +72,10 @@ Page {
         }
     }
 
+    onAlbumChanged: {
+        if (album) album.load();
+    }
+
     onVisibleChanged: {
         if (visible) reopenPicture();
     }
@@ -63,7 +63,8 @@ Popover {
                 deleteWithContentsClicked()
                 hide()
 
-                // Remove contents.
+                // Remove contents, which an album only reads when loaded.
+                album.load();
                 var list = album.allMediaSources;
                 for (var i = list.length-1; i >= 0; i--)
                     __mediaCollection.destroyMedia(list[i], true);
@@ -62,6 +62,39 @@ GridView {
     maximumFlickVelocity: units.gu(800)
     flickDeceleration: units.gu(400)
 
+    /*!
+    Tells the model which media are on screen, so they get loaded first
+    */
+    function __publishVisibleRange() {
+        if (!model || model.setVisibleRange === undefined || count === 0)
+            return;
+
+        // indexAt() gives -1 over the header and past a partial last row
+        var cells = Math.max(1, Math.floor(width / cellWidth)) * (Math.ceil(height / cellHeight) + 1);
+        var first = indexAt(contentX, contentY);
+        if (first < 0 && headerItem)
+            first = indexAt(contentX, contentY + headerItem.height);
+        var last = indexAt(contentX + width - 1, contentY + height - 1);
+        if (first < 0 && last < 0)
+            return;
+        if (first < 0)
+            first = Math.max(0, last - cells + 1);
+        if (last < 0)
+            last = Math.min(first + cells - 1, count - 1);
+
+        model.setVisibleRange(first, last);
+    }
+
+    onContentYChanged: visibleRangeTimer.restart()
+    onHeightChanged: visibleRangeTimer.restart()
+    onCountChanged: visibleRangeTimer.restart()
+
+    Timer {
+        id: visibleRangeTimer
+        interval: 100
+        onTriggered: photosGrid.__publishVisibleRange()
+    }
+
     // Use this rather than anchors.topMargin to prevent delegates from being
     // unloaded while scrolling out of view but still partially visible
     header: Item {
@@ -89,7 +122,7 @@ GridView {
             sourceFillMode: UbuntuShape.PreserveAspectCrop
             source: Image {
                 id: thumbImage
-                source: "image://thumbnailer/" + mediaSource.path + "?at=" + mediaSource.lastModified
+                source: "image://thumbnailer/" + mediaPath + "?at=" + mediaLastModified
                 asynchronous: true
                 fillMode: Image.PreserveAspectCrop
                 sourceSize {
@@ -115,7 +148,7 @@ GridView {
 				height: units.gu(5)
 				name: "media-playback-start"
 				color: "white"
-				visible: mediaSource.type === MediaSource.Video && thumbImage.status == Image.Ready
+				visible: mediaType === MediaSource.Video && thumbImage.status == Image.Ready
 			}
 
             OrganicItemInteraction {
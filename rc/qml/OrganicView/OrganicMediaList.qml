@@ -177,7 +177,7 @@ Item {
                 sourceFillMode: UbuntuShape.PreserveAspectCrop
                 source: Image {
                     id: thumbImage
-                    source: "image://thumbnailer/" + model.mediaSource.path + "?at=" + model.mediaSource.lastModified
+                    source: "image://thumbnailer/" + model.mediaPath + "?at=" + model.mediaLastModified
                     asynchronous: true
 
                     /* The SDK thumbnailer respects the freedesktop.org standard and uses 128 for the small
@@ -212,7 +212,7 @@ Item {
 					height: units.gu(5)
 					name: "media-playback-start"
 					color: "white"
-					visible: model.mediaSource.type === MediaSource.Video && thumbImage.status == Image.Ready
+					visible: model.mediaType === MediaSource.Video && thumbImage.status == Image.Ready
 				}
 
                 OrganicItemInteraction {
@@ -284,6 +284,29 @@ Item {
 
         orientation: Qt.Horizontal
 
+        // only the tray being browsed tells the model what is on screen
+        onMovementEnded: {
+            if (count === 0)
+                return;
+
+            // indexAt() gives -1 over the header, the spacing between
+            // thumbnails and past the last one
+            var first = indexAt(contentX + leftBuffer, height / 2);
+            if (first < 0)
+                first = indexAt(contentX + leftBuffer + spacing, height / 2);
+            var last = indexAt(contentX + width - rightBuffer, height / 2);
+            if (last < 0)
+                last = indexAt(contentX + width - rightBuffer - spacing, height / 2);
+            if (first < 0 && last < 0)
+                return;
+            if (first < 0)
+                first = 0;
+            if (last < 0)
+                last = count - 1;
+
+            mediaModel.setVisibleRange(first, Math.max(first, last));
+        }
+
         header: eventHeader
         spacing: __margin
         delegate: Loader {
@@ -26,6 +26,12 @@
 // media
 #include "media-collection.h"
 
+#include <QGuiApplication>
+
+// how long the application stays in the background before closed albums are
+// let go of
+static const int UNLOAD_DELAY_MSECS = 5 * 60 * 1000;
+
 /*!
  * \brief AlbumCollection::AlbumCollection
  */
@@ -33,31 +39,18 @@ AlbumCollection::AlbumCollection(MediaCollection *mediaCollection,
                                  AlbumTable *albumTable, AlbumTemplate *albumTemplate)
     : ContainerSourceCollection("AlbumCollection", creationDateTimeDescendingComparator),
       m_mediaCollection(mediaCollection),
-      m_albumTable(albumTable)
+      m_albumTable(albumTable),
+      m_unloadTimer(this)
 {
-    // Load existing albums from database.
+    // Load existing albums from database.  Their photos are linked up when
+    // each album is first opened or shown.
     QList<Album*> album_list;
-    m_albumTable->getAlbums(&album_list);
+    QHash<qint64, QList<qint64> > album_media;
+    m_albumTable->getAlbums(&album_list, &album_media);
     foreach (Album* a, album_list) {
         a->setAlbumTemplate(albumTemplate);
+        a->deferLoading(mediaInLibrary(album_media.value(a->id())));
         add(a);
-        int saved_current_page = a->currentPage();
-
-        // Link each album up with its photos.
-        QSet<DataObject*> photos;
-        QList<qint64> photo_list;
-        MediaSource *media;
-        m_albumTable->mediaForAlbum(a->id(), &photo_list);
-        foreach (qint64 mediaId, photo_list) {
-            media = m_mediaCollection->mediaForId(mediaId);
-            if (media)
-                photos.insert(media);
-        }
-
-        a->attachMany(photos);
-
-        // After photos are attached, restore the current page.
-        a->setCurrentPage(saved_current_page);
 
         // If there are no photos in the album, mark it as closed.
         // This is needed for the case where the user exits the application while
@@ -73,6 +66,15 @@ AlbumCollection::AlbumCollection(MediaCollection *mediaCollection,
                 SIGNAL(contentsChanged(const QSet<DataObject*>*,const QSet<DataObject*>*, bool)),
                 this,
                 SLOT(onMediaAddedRemoved(const QSet<DataObject*>*,const QSet<DataObject*>*, bool)));
+
+    // Closed albums are let go of once the application has been in the
+    // background for a while, which is when it's most likely to be short of
+    // memory, and least likely to need them again straight away.
+    m_unloadTimer.setSingleShot(true);
+    m_unloadTimer.setInterval(UNLOAD_DELAY_MSECS);
+    QObject::connect(&m_unloadTimer, SIGNAL(timeout()), this, SLOT(unloadClosedAlbums()));
+    QObject::connect(qApp, SIGNAL(applicationStateChanged(Qt::ApplicationState)),
+                     this, SLOT(onApplicationStateChanged(Qt::ApplicationState)));
 }
 
 /*!
@@ -106,6 +108,24 @@ void AlbumCollection::notifyAlbumCurrentPageContentsChanged(Album* album)
     emit albumCurrentPageContentsChanged(album);
 }
 
+/*!
+ * \brief AlbumCollection::notifyAlbumContentsChanged
+ * Called by a member Album when media are attached to or detached from it
+ * \param album
+ * \param added
+ * \param removed
+ */
+void AlbumCollection::notifyAlbumContentsChanged(Album* album,
+                                                 const QSet<DataObject*>* added,
+                                                 const QSet<DataObject*>* removed)
+{
+    if (added != NULL)
+        indexAlbumMedia(album, *added, true);
+
+    if (removed != NULL)
+        indexAlbumMedia(album, *removed, false);
+}
+
 /*!
  * \brief AlbumCollection::onMediaAddedRemoved
  * \param added
@@ -116,21 +136,118 @@ void AlbumCollection::onMediaAddedRemoved(const QSet<DataObject *> *added,
                                              bool notify)
 {
     if (removed != NULL) {
-        // TODO: this could maybe be optimized.  Many albums might not care about
-        // the particular photo being added.
-        DataObject* album_object;
-        foreach (album_object, getAsSet()) {
-            Album* album = qobject_cast<Album*>(album_object);
-            Q_ASSERT(album != NULL);
+        // Only the albums holding removed media are touched, each once
+        QHash<Album*, QSet<DataObject*> > toDetach;
 
-            DataObject* object;
-            foreach (object, *removed) {
-                MediaSource* media = qobject_cast<MediaSource*>(object);
-                Q_ASSERT(media != NULL);
+        DataObject* object;
+        foreach (object, *removed) {
+            Album* album;
+            foreach (album, m_mediaAlbums.value(object))
+                toDetach[album].insert(object);
+        }
 
-                album->detach(media, true);
-            }
+        QHashIterator<Album*, QSet<DataObject*> > i(toDetach);
+        while (i.hasNext()) {
+            i.next();
+            i.key()->detachMany(i.value());
         }
+
+        forgetUnloadedMedia(*removed);
+    }
+}
+
+/*!
+ * \brief AlbumCollection::forgetUnloadedMedia
+ * Albums that aren't loaded aren't in the index, but each keeps the ids of
+ * the media it holds, so they're told about the removed media by id
+ * \param removed
+ */
+void AlbumCollection::forgetUnloadedMedia(const QSet<DataObject*>& removed)
+{
+    QSet<qint64> removed_ids;
+    foreach (DataObject* object, removed) {
+        MediaSource* media = qobject_cast<MediaSource*>(object);
+        if (media != NULL)
+            removed_ids.insert(media->id());
+    }
+
+    if (removed_ids.isEmpty())
+        return;
+
+    foreach (Album* album, getAllAsType<Album*>()) {
+        if (!album->isLoaded())
+            album->forgetMedia(removed_ids);
+    }
+}
+
+/*!
+ * \brief AlbumCollection::mediaInLibrary
+ * Media whose file has gone, or that are filtered out, are left in the
+ * database but never linked up with their albums, so they don't count
+ * \param mediaIds
+ * \return the ids of the media the library holds
+ */
+QList<qint64> AlbumCollection::mediaInLibrary(const QList<qint64>& mediaIds) const
+{
+    QList<qint64> found;
+    foreach (qint64 mediaId, mediaIds) {
+        if (m_mediaCollection->mediaForId(mediaId) != NULL)
+            found.append(mediaId);
+    }
+
+    return found;
+}
+
+/*!
+ * \brief AlbumCollection::unloadClosedAlbums
+ * Lets go of the media and pages of the albums that aren't open; they're
+ * loaded again when next needed
+ */
+void AlbumCollection::unloadClosedAlbums()
+{
+    foreach (Album* album, getAllAsType<Album*>()) {
+        if (album->isClosed())
+            album->unload();
+    }
+}
+
+/*!
+ * \brief AlbumCollection::onApplicationStateChanged
+ * \param state
+ */
+void AlbumCollection::onApplicationStateChanged(Qt::ApplicationState state)
+{
+    if (state == Qt::ApplicationHidden || state == Qt::ApplicationSuspended) {
+        if (!m_unloadTimer.isActive())
+            m_unloadTimer.start();
+    } else {
+        m_unloadTimer.stop();
+    }
+}
+
+/*!
+ * \brief AlbumCollection::indexAlbumMedia
+ * \param album
+ * \param media
+ * \param attached
+ */
+void AlbumCollection::indexAlbumMedia(Album* album, const QSet<DataObject*>& media,
+                                      bool attached)
+{
+    DataObject* object;
+    foreach (object, media) {
+        if (attached) {
+            m_mediaAlbums[object].insert(album);
+            continue;
+        }
+
+        QHash<DataObject*, QSet<Album*> >::iterator albums = m_mediaAlbums.find(object);
+        if (albums == m_mediaAlbums.end())
+            continue;
+
+        albums->remove(album);
+        if (albums->isEmpty())
+            m_mediaAlbums.erase(albums);
     }
 }
 
@@ -152,6 +269,7 @@ void AlbumCollection::notifyContentsChanged(const QSet<DataObject*>* added,
 
             // Add the album.
             m_albumTable->addAlbum(album);
+            indexAlbumMedia(album, album->contained()->getAsSet(), true);
 
             // Add initial photos.
             foreach(DataObject* o, album->contained()->getAll()) {
@@ -168,6 +286,7 @@ void AlbumCollection::notifyContentsChanged(const QSet<DataObject*>* added,
             Q_ASSERT(album != NULL);
 
             m_albumTable->removeAlbum(album);
+            indexAlbumMedia(album, album->contained()->getAsSet(), false);
         }
     }
 }
@@ -26,7 +26,11 @@
 #include "container-source-collection.h"
 #include "data-object.h"
 
+#include <QHash>
+#include <QList>
 #include <QObject>
+#include <QSet>
+#include <QTimer>
 
 class AlbumTable;
 class AlbumTemplate;
@@ -51,8 +55,14 @@ public:
     static bool creationDateTimeAscendingComparator(DataObject* a, DataObject* b);
     static bool creationDateTimeDescendingComparator(DataObject* a, DataObject* b);
 
+public slots:
+    void unloadClosedAlbums();
+
 protected:
     virtual void notifyAlbumCurrentPageContentsChanged(Album* album);
+    virtual void notifyAlbumContentsChanged(Album* album,
+                                            const QSet<DataObject*>* added,
+                                            const QSet<DataObject*>* removed);
 
     virtual void notifyContentsChanged(const QSet<DataObject*>* added,
                                        const QSet<DataObject*>* removed,
@@ -62,10 +72,18 @@ private slots:
     void onMediaAddedRemoved(const QSet<DataObject*>* added,
                              const QSet<DataObject*>* removed,
                              bool notify);
+    void onApplicationStateChanged(Qt::ApplicationState state);
 
 private:
+    void indexAlbumMedia(Album* album, const QSet<DataObject*>& media, bool attached);
+    void forgetUnloadedMedia(const QSet<DataObject*>& removed);
+    QList<qint64> mediaInLibrary(const QList<qint64>& mediaIds) const;
+
     MediaCollection *m_mediaCollection;
     AlbumTable *m_albumTable;
+    QTimer m_unloadTimer;
+    // the albums each media is in
+    QHash<DataObject*, QSet<Album*> > m_mediaAlbums;
 };
 
 #endif  // GALLERY_ALBUM_COLLECTION_H_
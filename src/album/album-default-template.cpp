@@ -49,6 +49,24 @@ void AlbumDefaultTemplate::resetBestFitData()
     m_nextDecisionPageType = LANDSCAPE;
 }
 
+/*!
+ * \brief AlbumDefaultTemplate::bestFitState
+ * \return the page type the next landscape/portrait pair will get
+ */
+int AlbumDefaultTemplate::bestFitState() const
+{
+    return m_nextDecisionPageType;
+}
+
+/*!
+ * \brief AlbumDefaultTemplate::restoreBestFitState
+ * \param state as returned by bestFitState()
+ */
+void AlbumDefaultTemplate::restoreBestFitState(int state)
+{
+    m_nextDecisionPageType = static_cast<PageOrientation>(state);
+}
+
 /*!
  * \brief AlbumDefaultTemplate::getBestFitPage
  * \param isLeft
@@ -36,6 +36,8 @@ public:
     AlbumDefaultTemplate();
 
     virtual void resetBestFitData();
+    virtual int bestFitState() const;
+    virtual void restoreBestFitState(int state);
     virtual AlbumTemplatePage* getBestFitPage(bool isLeft, int numPhotos,
                                               PageOrientation photoOrientations[]);
 
@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2014 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "album-layout.h"
+#include "album-template.h"
+
+// media
+#include "media-source.h"
+
+#include <algorithm>
+
+/*!
+ * \brief AlbumLayout::AlbumLayout
+ */
+AlbumLayout::AlbumLayout()
+{
+}
+
+/*!
+ * \brief AlbumLayout::pages
+ * \return the content pages in order, always an even number of them
+ */
+const QList<AlbumLayout::Page>& AlbumLayout::pages() const
+{
+    return m_pages;
+}
+
+/*!
+ * \brief AlbumLayout::populatedCount
+ * \return the number of pages holding media
+ */
+int AlbumLayout::populatedCount() const
+{
+    int count = 0;
+    foreach (const Page& page, m_pages) {
+        if (page.count > 0)
+            ++count;
+    }
+
+    return count;
+}
+
+/*!
+ * \brief AlbumLayout::update
+ * Lays the media out again, starting from the page holding the first media
+ * that differs from the old list, or an earlier one whose choice of template
+ * looked ahead at it.  The last page may be empty, to always have an even
+ * number of pages.
+ * \param albumTemplate the template the current pages were laid out with
+ * \param oldMedia the media the current pages were laid out for
+ * \param media
+ * \return which pages were laid out again and which were kept
+ */
+AlbumLayout::Change AlbumLayout::update(AlbumTemplate* albumTemplate,
+                                        const QList<MediaSource*>& oldMedia,
+                                        const QList<MediaSource*>& media)
+{
+    Q_ASSERT(albumTemplate != NULL);
+
+    // how much of the old list is left as it was at either end
+    int limit = qMin(media.count(), oldMedia.count());
+    int prefix = 0;
+    while (prefix < limit && media.at(prefix) == oldMedia.at(prefix))
+        ++prefix;
+
+    int suffix = 0;
+    while (suffix < limit - prefix
+           && media.at(media.count() - 1 - suffix) == oldMedia.at(oldMedia.count() - 1 - suffix))
+        ++suffix;
+
+    int shift = media.count() - oldMedia.count();
+
+    int first_page = 0;
+    if (m_pages.isEmpty()) {
+        albumTemplate->resetBestFitData();
+    } else {
+        first_page = m_pages.count() - 1;
+        while (first_page > 0 && m_pages.at(first_page).start > prefix)
+            --first_page;
+        while (first_page > 0 && m_pages.at(first_page - 1).start
+               + std::max(2, m_pages.at(first_page - 1).frames) > prefix)
+            --first_page;
+
+        albumTemplate->restoreBestFitState(m_pages.at(first_page).fitState);
+    }
+
+    int index = m_pages.isEmpty() ? 0 : m_pages.at(first_page).start;
+    int page = first_page;
+    int reuse_from = m_pages.count();
+    int old_page = first_page;
+    QList<Page> laid_out;
+
+    while (index < media.count() || page % 2 != 0) {
+        // Past the last change, look for an old page to pick up from
+        if (index >= media.count() - suffix) {
+            while (old_page < m_pages.count() && m_pages.at(old_page).start < index - shift)
+                ++old_page;
+
+            if (old_page < m_pages.count()
+                    && m_pages.at(old_page).start == index - shift
+                    && old_page % 2 == page % 2
+                    && m_pages.at(old_page).fitState == albumTemplate->bestFitState()) {
+                reuse_from = old_page;
+                break;
+            }
+        }
+
+        PageOrientation next_photo_orientations[2];
+        int next_photos_count = std::min(media.count() - index, 2);
+        for(int i = 0; i < next_photos_count; ++i) {
+            QSize size = media.at(index + i)->size();
+            next_photo_orientations[i] = (size.height() > size.width()
+                                          ? PORTRAIT : LANDSCAPE);
+        }
+
+        Page layout;
+        layout.start = index;
+        layout.fitState = albumTemplate->bestFitState();
+
+        // First page is on the left.
+        layout.templatePage = albumTemplate->getBestFitPage(page % 2 == 0, next_photos_count,
+                                                            next_photo_orientations);
+        layout.frames = layout.templatePage->frameCount();
+        layout.count = std::min(media.count() - index, layout.frames);
+        laid_out.append(layout);
+
+        index += layout.count;
+        ++page;
+    }
+
+    QList<Page> kept = m_pages.mid(reuse_from);
+    for (int i = 0; i < kept.count(); ++i)
+        kept[i].start += shift;
+
+    m_pages = m_pages.mid(0, first_page) + laid_out + kept;
+
+    Change change = { first_page, laid_out.count(), reuse_from };
+
+    return change;
+}
+
+/*!
+ * \brief AlbumLayout::clear
+ * The next update() lays out every page
+ */
+void AlbumLayout::clear()
+{
+    m_pages.clear();
+}
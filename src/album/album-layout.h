@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2014 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GALLERY_ALBUM_LAYOUT_H_
+#define GALLERY_ALBUM_LAYOUT_H_
+
+#include <QList>
+
+class AlbumTemplate;
+class AlbumTemplatePage;
+class MediaSource;
+
+/**
+  * Lays an album's media out on its content pages through an AlbumTemplate.
+  * After the media list changes only the pages from the first change on are
+  * laid out again, and once they line up with the old ones (the same media
+  * first, on the same side, with the template in the same state) the rest
+  * would come out as before, so those are kept.
+  */
+class AlbumLayout
+{
+public:
+    // How a content page was laid out, so the layout can be picked up again
+    // from that page
+    struct Page {
+        int start;
+        int count;
+        int frames;
+        int fitState;
+        AlbumTemplatePage* templatePage;
+    };
+
+    // The pages from firstPage up to firstPage + laidOut are new.  They
+    // replace the old ones up to reuseFrom, and the old ones from there on
+    // are kept, moved on by firstPage + laidOut - reuseFrom
+    struct Change {
+        int firstPage;
+        int laidOut;
+        int reuseFrom;
+    };
+
+    AlbumLayout();
+
+    const QList<Page>& pages() const;
+    int populatedCount() const;
+
+    Change update(AlbumTemplate* albumTemplate, const QList<MediaSource*>& oldMedia,
+                  const QList<MediaSource*>& media);
+    void clear();
+
+private:
+    QList<Page> m_pages;
+};
+
+#endif  // GALLERY_ALBUM_LAYOUT_H_
@@ -68,6 +68,19 @@ int AlbumPage::pageNumber() const
     return m_pageNumber;
 }
 
+/*!
+ * \brief AlbumPage::setPageNumber
+ * \param pageNumber
+ */
+void AlbumPage::setPageNumber(int pageNumber)
+{
+    if (pageNumber == m_pageNumber)
+        return;
+
+    m_pageNumber = pageNumber;
+    emit pageNumberChanged();
+}
+
 /*!
  * \brief AlbumPage::templatePage
  * \return
@@ -57,6 +57,7 @@ public:
     AlbumPage(Album* owner, int pageNumber, AlbumTemplatePage* templatePage);
 
     int pageNumber() const;
+    void setPageNumber(int pageNumber);
     AlbumTemplatePage* templatePage() const;
     QUrl qmlRc() const;
 
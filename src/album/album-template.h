@@ -38,6 +38,9 @@ public:
     const QList<AlbumTemplatePage*>& pages() const;
 
     virtual void resetBestFitData() = 0;
+    // lets a layout be picked up again from a page part way through
+    virtual int bestFitState() const = 0;
+    virtual void restoreBestFitState(int state) = 0;
     virtual AlbumTemplatePage* getBestFitPage(bool isLeft, int numPhotos,
                                                  PageOrientation photoOrientations[]) = 0;
 
@@ -103,7 +103,11 @@ void Album::initInstance()
     m_closed = true;
     m_populatedPagesCount = 0;
     m_contentPages = new SourceCollection(QString("Pages for ") + m_title);
+    m_contentPages->setComparator(pageComparator);
     m_refreshingContainer = false;
+    m_loaded = true;
+    m_hydrating = false;
+    m_unloading = false;
     m_id = INVALID_ID;
     m_coverNickname = "default";
 
@@ -145,8 +149,11 @@ QSet<DataObject *> Album::mediaList2ObjectSet(QVariant mediaList) const
 void Album::addMediaSource(QVariant vmedia)
 {
     MediaSource* media = UncheckedVariantToObject<MediaSource*>(vmedia);
-    if (media != NULL)
-        attach(media);
+    if (media == NULL)
+        return;
+
+    load();
+    attach(media);
 }
 
 /*!
@@ -157,6 +164,7 @@ void Album::addMediaSource(QVariant vmedia)
 QVariant Album::addSelectedMediaSources(QVariant mediaList)
 {
     QSet<DataObject*> mediaSet = mediaList2ObjectSet(mediaList);
+    load();
 
     // Only adding ones that aren't already in the set.
     QSet<DataObject*> adding = mediaSet - contained()->getAsSet();
@@ -180,8 +188,11 @@ QVariant Album::addSelectedMediaSources(QVariant mediaList)
 void Album::removeMediaSource(QVariant vmedia)
 {
     MediaSource* media = UncheckedVariantToObject<MediaSource*>(vmedia);
-    if (media != NULL)
-        detach(media, true);
+    if (media == NULL)
+        return;
+
+    load();
+    detach(media, true);
 }
 
 /*!
@@ -192,6 +203,7 @@ void Album::removeMediaSource(QVariant vmedia)
 void Album::removeSelectedMediaSources(QVariant mediaList)
 {
     QSet<DataObject*> mediaSet = mediaList2ObjectSet(mediaList);
+    load();
     detachMany(mediaSet);
 }
 
@@ -200,8 +212,10 @@ void Album::removeSelectedMediaSources(QVariant mediaList)
  * \param page
  * \return
  */
-QVariant Album::getPage(int page) const
+QVariant Album::getPage(int page)
 {
+    load();
+
     AlbumPage* album_page = getAlbumPage(page);
 
     return (album_page != NULL) ? QVariant::fromValue(album_page) : QVariant();
@@ -212,12 +226,14 @@ QVariant Album::getPage(int page) const
  * \param vmedia
  * \return
  */
-int Album::getPageForMediaSource(QVariant vmedia) const
+int Album::getPageForMediaSource(QVariant vmedia)
 {
     MediaSource* media = UncheckedVariantToObject<MediaSource*>(vmedia);
     if (media == NULL)
         return -1;
 
+    load();
+
     if (m_contentPages == NULL)
         return -1;
 
@@ -236,12 +252,14 @@ int Album::getPageForMediaSource(QVariant vmedia) const
  * \param vmedia
  * \return
  */
-bool Album::containsMedia(QVariant vmedia) const
+bool Album::containsMedia(QVariant vmedia)
 {
     MediaSource* media = UncheckedVariantToObject<MediaSource*>(vmedia);
     if (media == NULL)
         return false;
 
+    load();
+
     return ContainerSource::contains(media);
 }
 
@@ -250,15 +268,139 @@ bool Album::containsMedia(QVariant vmedia) const
  * \param vContainerSource
  * \return
  */
-bool Album::containsAll(QVariant vContainerSource) const
+bool Album::containsAll(QVariant vContainerSource)
 {
     ContainerSource* container = UncheckedVariantToObject<ContainerSource*>(vContainerSource);
     if (container == NULL)
         return false;
 
+    load();
+
     return ContainerSource::containsAll(container);
 }
 
+/*!
+ * \brief Album::load
+ * Links the album up with the media it holds and lays out its pages, the
+ * first time they're needed
+ */
+void Album::load()
+{
+    if (m_loaded)
+        return;
+
+    // Don't call AlbumCollection::instance directly -- it's possible the
+    // object is orphaned
+    AlbumCollection* membership = qobject_cast<AlbumCollection*>(memberOf());
+    if (membership == NULL)
+        return;
+
+    QSet<DataObject*> photos;
+    foreach (qint64 mediaId, m_storedMedia) {
+        MediaSource* media = membership->m_mediaCollection->mediaForId(mediaId);
+        if (media)
+            photos.insert(media);
+    }
+    m_storedMedia.clear();
+
+    int saved_current_page = m_currentPage;
+    m_loaded = true;
+    m_hydrating = true;
+
+    attachMany(photos);
+
+    // After photos are attached, restore the current page.
+    setCurrentPage(saved_current_page);
+
+    m_hydrating = false;
+}
+
+/*!
+ * \brief Album::unload
+ * Lets go of the album's media and pages, keeping only the ids of the media
+ * it holds, until it's loaded again.  Nothing is laid out or signalled, as the
+ * album looks the same once it's loaded.  Albums not in the database yet,
+ * and empty ones, are kept.
+ */
+void Album::unload()
+{
+    if (!m_loaded || id() == INVALID_ID || contained()->count() == 0)
+        return;
+
+    m_loaded = false;
+    m_unloading = true;
+
+    // a copy, as the set shrinks while it's detached
+    QSet<DataObject*> photos = contained()->getAsSet();
+    foreach (DataObject* object, photos)
+        m_storedMedia.append(qobject_cast<MediaSource*>(object)->id());
+    detachMany(photos, false);
+
+    m_contentPages->destroyAll(true, true);
+    m_layout.clear();
+    m_allMediaSources.clear();
+    m_allAlbumPages.clear();
+    m_populatedPagesCount = 0;
+
+    m_unloading = false;
+}
+
+/*!
+ * \brief Album::deferLoading
+ * Marks an album read from the database as not loaded yet
+ * \param mediaIds the ids of the media it holds that are in the library
+ */
+void Album::deferLoading(const QList<qint64>& mediaIds)
+{
+    Q_ASSERT(contained()->count() == 0);
+
+    m_loaded = false;
+    m_storedMedia = mediaIds;
+}
+
+/*!
+ * \brief Album::isLoaded
+ * \return
+ */
+bool Album::isLoaded() const
+{
+    return m_loaded;
+}
+
+/*!
+ * \brief Album::containedCount \reimp
+ * \return
+ */
+int Album::containedCount() const
+{
+    return m_loaded ? ContainerSource::containedCount() : m_storedMedia.count();
+}
+
+/*!
+ * \brief Album::forgetMedia
+ * Takes the media that have gone out of the library out of an album that
+ * isn't loaded
+ * \param mediaIds
+ */
+void Album::forgetMedia(const QSet<qint64>& mediaIds)
+{
+    Q_ASSERT(!m_loaded);
+    Q_ASSERT(m_albumTable);
+
+    int stored_count = m_storedMedia.count();
+    QMutableListIterator<qint64> i(m_storedMedia);
+    while (i.hasNext()) {
+        qint64 mediaId = i.next();
+        if (mediaIds.contains(mediaId)) {
+            m_albumTable->detachFromAlbum(id(), mediaId);
+            i.remove();
+        }
+    }
+
+    if (m_storedMedia.count() != stored_count)
+        emit containerContentsChanged(NULL, NULL);
+}
+
 /*!
  * \brief Album::title
  * \return
@@ -342,6 +484,9 @@ AlbumTemplate* Album::albumTemplate() const
 void Album::setAlbumTemplate(AlbumTemplate *albumTemplate)
 {
     m_albumTemplate = albumTemplate;
+
+    // the next change lays out every page with the new template
+    m_layout.clear();
 }
 
 /*!
@@ -465,6 +610,10 @@ void Album::setCurrentPage(int page)
  */
 void Album::setClosed(bool closed)
 {
+    // an album is loaded when it's opened
+    if (!closed)
+        load();
+
     if (m_closed == closed)
         return;
 
@@ -534,6 +683,8 @@ void Album::setCoverNickname(QString name)
  */
 SourceCollection* Album::contentPages()
 {
+    load();
+
     return (SourceCollection*) m_contentPages;
 }
 
@@ -554,6 +705,8 @@ AlbumPage* Album::getAlbumPage(int page) const
  */
 QQmlListProperty<MediaSource> Album::qmlAllMediaSources()
 {
+    load();
+
     return QQmlListProperty<MediaSource>(this, m_allMediaSources);
 }
 
@@ -572,6 +725,8 @@ void Album::setAlbumTable(AlbumTable *albumTable)
  */
 QQmlListProperty<AlbumPage> Album::qmlPages()
 {
+    load();
+
     return QQmlListProperty<AlbumPage>(this, m_allAlbumPages);
 }
 
@@ -583,7 +738,8 @@ void Album::notifyCurrentPageChanged()
     Q_ASSERT(m_albumTable);
     if (!m_refreshingContainer) {
         emit currentPageChanged();
-        m_albumTable->setCurrentPage(m_id, m_currentPage);
+        if (!m_hydrating)
+            m_albumTable->setCurrentPage(m_id, m_currentPage);
     }
 }
 
@@ -595,7 +751,8 @@ void Album::notifyClosedChanged()
     Q_ASSERT(m_albumTable);
     if (!m_refreshingContainer) {
         emit closedChanged();
-        m_albumTable->setIsClosed(m_id, m_closed);
+        if (!m_hydrating)
+            m_albumTable->setIsClosed(m_id, m_closed);
     }
 }
 
@@ -642,6 +799,7 @@ void Album::destroySource(bool destroyBacking, bool asOrphan)
 
     if (m_contentPages != NULL)
         m_contentPages->destroyAll(true, true);
+    m_layout.clear();
 }
 
 /*!
@@ -654,6 +812,17 @@ void Album::notifyContainerContentsChanged(const QSet<DataObject*>* added,
 {
     Q_ASSERT(m_albumTemplate);
     Q_ASSERT(m_albumTable);
+
+    AlbumCollection* membership = qobject_cast<AlbumCollection*>(memberOf());
+
+    // the collection's index of which album holds which media is the only
+    // thing to keep up to date while unloading
+    if (m_unloading) {
+        if (membership != NULL)
+            membership->notifyAlbumContentsChanged(this, added, removed);
+        return;
+    }
+
     bool stashed_refreshing_container = m_refreshingContainer;
     m_refreshingContainer = true;
 
@@ -661,9 +830,13 @@ void Album::notifyContainerContentsChanged(const QSet<DataObject*>* added,
 
     ContainerSource::notifyContainerContentsChanged(added, removed);
 
+    if (membership != NULL)
+        membership->notifyAlbumContentsChanged(this, added, removed);
+
     // Update database.
-    // If the album isn't in the DB yet, ignore for now.
-    if (id() != INVALID_ID) {
+    // If the album isn't in the DB yet, ignore for now.  Nor is there anything
+    // to write when the contents are only being loaded or let go of.
+    if (id() != INVALID_ID && !m_hydrating) {
         if (added != NULL) {
             QSetIterator<DataObject*> i(*added);
             while (i.hasNext()) {
@@ -683,50 +856,8 @@ void Album::notifyContainerContentsChanged(const QSet<DataObject*>* added,
         }
     }
 
-    // TODO: Can be smarter than this, but since we don't know how position(s)
-    // in the contained sources list have now changed, need to reset and start
-    // afresh
     int stashed_current_page = m_currentPage;
-    m_contentPages->destroyAll(true, true);
-    m_populatedPagesCount = 0;
-
-    // Convert contained DataObjects into a queue to process in order
-    QQueue<DataObject*> queue;
-    queue.append(contained()->getAll());
-
-    int building_page = contentToAbsolutePage(0);
-    bool page_is_left = true; // First page is on the left.
-
-    m_albumTemplate->resetBestFitData();
-    // We loop until we've added all photos, and then ensure there's always an
-    // even number of pages (the last one of which may be empty).
-    while(!queue.isEmpty() || m_contentPages->count() % 2 != 0) {
-        PageOrientation next_photo_orientations[2];
-        int next_photos_count = std::min(queue.count(), 2);
-        for(int i = 0; i < next_photos_count; ++i) {
-            MediaSource* photo = qobject_cast<MediaSource*>(queue.at(i));
-            Q_ASSERT(photo != NULL);
-            QSize size = photo->size();
-            next_photo_orientations[i] = (size.height() > size.width()
-                                          ? PORTRAIT : LANDSCAPE);
-        }
-
-        AlbumTemplatePage* template_page =
-                m_albumTemplate->getBestFitPage(page_is_left, next_photos_count,
-                                                   next_photo_orientations);
-        AlbumPage* page = new AlbumPage(this, building_page, template_page);
-
-        int photos_on_page = std::min(queue.count(), template_page->frameCount());
-        for(int i = 0; i < photos_on_page; ++i)
-            page->attach(queue.dequeue());
-
-        m_contentPages->add(page);
-        if (photos_on_page > 0)
-            ++m_populatedPagesCount;
-
-        ++building_page;
-        page_is_left = !page_is_left;
-    }
+    layoutPages();
 
     // update QML lists and notify QML watchers
     m_allMediaSources = CastListToType<DataObject*, MediaSource*>(contained()->getAll());
@@ -735,7 +866,7 @@ void Album::notifyContainerContentsChanged(const QSet<DataObject*>* added,
     m_refreshingContainer = stashed_refreshing_container;
 
     // If there's no content, add the "add photos" page.
-    if (containedCount() == 0)
+    if (contained()->count() == 0)
         createAddPhotosPage();
 
     // return to stashed current page, unless pages have been removed ... note
@@ -756,6 +887,80 @@ void Album::notifyContainerContentsChanged(const QSet<DataObject*>* added,
     notifyCurrentPageContentsChanged();
 }
 
+/*!
+ * \brief Album::layoutPages
+ * Replaces the pages AlbumLayout lays out again, and renumbers the ones it
+ * keeps
+ */
+void Album::layoutPages()
+{
+    QList<MediaSource*> media = CastListToType<DataObject*, MediaSource*>(contained()->getAll());
+
+    // pages without a layout (the "add photos" pages) all go
+    if (m_layout.pages().isEmpty())
+        m_contentPages->destroyAll(true, true);
+
+    int old_count = m_layout.pages().count();
+    AlbumLayout::Change change = m_layout.update(m_albumTemplate, m_allMediaSources, media);
+
+    QSet<DataObject*> old_pages;
+    for (int i = change.firstPage; i < change.reuseFrom; ++i)
+        old_pages.insert(m_contentPages->getAt(i));
+
+    QList<AlbumPage*> kept_pages;
+    for (int i = change.reuseFrom; i < old_count; ++i)
+        kept_pages.append(m_contentPages->getAtAsType<AlbumPage*>(i));
+
+    if (!old_pages.isEmpty())
+        m_contentPages->destroyMany(old_pages, true, true);
+
+    // the kept pages all move by the same amount, so stay in order
+    int moved_by = change.firstPage + change.laidOut - change.reuseFrom;
+    AlbumPage* kept_page;
+    foreach (kept_page, kept_pages)
+        kept_page->setPageNumber(kept_page->pageNumber() + moved_by);
+
+    QSet<DataObject*> new_pages;
+    for (int page = change.firstPage; page < change.firstPage + change.laidOut; ++page) {
+        const AlbumLayout::Page& layout = m_layout.pages().at(page);
+        AlbumPage* album_page = new AlbumPage(this, contentToAbsolutePage(page),
+                                              layout.templatePage);
+
+        QSet<DataObject*> on_page;
+        for(int i = 0; i < layout.count; ++i)
+            on_page.insert(media.at(layout.start + i));
+        album_page->attachMany(on_page);
+
+        new_pages.insert(album_page);
+    }
+
+    if (!new_pages.isEmpty())
+        m_contentPages->addMany(new_pages);
+
+    m_populatedPagesCount = m_layout.populatedCount();
+}
+
+/*!
+ * \brief Album::pageComparator keeps the pages in page number order, which
+ * is not the order they are created in
+ * \param a
+ * \param b
+ * \return
+ */
+bool Album::pageComparator(DataObject* a, DataObject* b)
+{
+    AlbumPage* pagea = qobject_cast<AlbumPage*>(a);
+    Q_ASSERT(pagea != NULL);
+
+    AlbumPage* pageb = qobject_cast<AlbumPage*>(b);
+    Q_ASSERT(pageb != NULL);
+
+    if (pagea->pageNumber() != pageb->pageNumber())
+        return pagea->pageNumber() < pageb->pageNumber();
+
+    return DataCollection::defaultDataObjectComparator(a, b);
+}
+
 /*!
  * \brief Album::contentToAbsolutePage
  * \param contentPage
@@ -815,6 +1020,9 @@ void Album::onAlbumPageContentChanged(const QSet<DataObject*>* added,
                                       const QSet<DataObject*>* removed,
                                       bool notify)
 {
+    if (m_unloading)
+        return;
+
     m_allAlbumPages = CastListToType<DataObject*, AlbumPage*>(m_contentPages->getAll());
 
     bool changed = false;
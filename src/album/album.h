@@ -21,6 +21,7 @@
 #ifndef GALLERY_ALBUM_H_
 #define GALLERY_ALBUM_H_
 
+#include "album-layout.h"
 #include "album-page.h"
 #include "album-template.h"
 
@@ -31,7 +32,9 @@
 #include "media-source.h"
 
 #include <QDateTime>
+#include <QList>
 #include <QQmlListProperty>
+#include <QSet>
 #include <QString>
 #include <QVariant>
 
@@ -94,6 +97,8 @@ signals:
     void idChanged();
 
 public:
+    friend class AlbumCollection;
+
     static const char *DEFAULT_TITLE;
     static const char *DEFAULT_SUBTITLE;
     static const int PAGES_PER_COVER;
@@ -110,10 +115,16 @@ public:
     Q_INVOKABLE QVariant addSelectedMediaSources(QVariant mediaList);
     Q_INVOKABLE void removeMediaSource(QVariant vmedia);
     Q_INVOKABLE void removeSelectedMediaSources(QVariant mediaList);
-    Q_INVOKABLE QVariant getPage(int page) const;
-    Q_INVOKABLE int getPageForMediaSource(QVariant vmedia) const;
-    Q_INVOKABLE bool containsMedia(QVariant vmedia) const;
-    Q_INVOKABLE bool containsAll(QVariant vContainerSource) const;
+    Q_INVOKABLE QVariant getPage(int page);
+    Q_INVOKABLE int getPageForMediaSource(QVariant vmedia);
+    Q_INVOKABLE bool containsMedia(QVariant vmedia);
+    Q_INVOKABLE bool containsAll(QVariant vContainerSource);
+    Q_INVOKABLE void load();
+
+    void unload();
+    void deferLoading(const QList<qint64>& mediaIds);
+    bool isLoaded() const;
+    virtual int containedCount() const;
 
     const QString& title() const;
     void setTitle(QString title);
@@ -173,8 +184,12 @@ private slots:
                                    bool notify);
 
 private:
+    static bool pageComparator(DataObject* a, DataObject* b);
+
     void initInstance();
     QSet<DataObject*> mediaList2ObjectSet(QVariant mediaList) const;
+    void layoutPages();
+    void forgetMedia(const QSet<qint64>& mediaIds);
 
     AlbumTemplate *m_albumTemplate;
     QString m_title;
@@ -185,9 +200,18 @@ private:
     bool m_newAlbum;
     int m_populatedPagesCount;
     SourceCollection* m_contentPages;
+    AlbumLayout m_layout;
     QList<MediaSource*> m_allMediaSources;
     QList<AlbumPage*> m_allAlbumPages;
     bool m_refreshingContainer;
+    // Until it's loaded, the album only knows the ids of the media it holds
+    bool m_loaded;
+    QList<qint64> m_storedMedia;
+    // Set while the contents are brought in line with the database, rather
+    // than changed
+    bool m_hydrating;
+    // Set while the media and pages are let go of, which nobody is told about
+    bool m_unloading;
     qint64 m_id;
     QString m_coverNickname;
     AlbumTable *m_albumTable;
@@ -66,10 +66,11 @@ void ContainerSource::detach(DataObject* object, bool notify)
 /*!
  * \brief ContainerSource::detachMany
  * \param objects
+ * \param notify
  */
-void ContainerSource::detachMany(const QSet<DataObject*>& objects)
+void ContainerSource::detachMany(const QSet<DataObject*>& objects, bool notify)
 {
-    m_contained.removeMany(objects, true);
+    m_contained.removeMany(objects, notify);
 }
 
 /*!
@@ -47,11 +47,11 @@ public:
     void attachMany(const QSet<DataObject*>& objects);
 
     void detach(DataObject* object, bool notify);
-    void detachMany(const QSet<DataObject*>& objects);
+    void detachMany(const QSet<DataObject*>& objects, bool notify = true);
 
     bool contains(DataObject* object) const;
     bool containsAll(ContainerSource* collection) const;
-    int containedCount() const;
+    virtual int containedCount() const;
     const ViewCollection* contained() const;
 
 protected:
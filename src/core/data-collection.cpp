@@ -21,13 +21,170 @@
 #include "data-object.h"
 
 #include <QQmlEngine>
+#include <QThread>
+#include <QtConcurrentMap>
+
+#include <algorithm>
+#include <climits>
+
+// Batches of at least this many objects are sorted in parallel chunks by
+// addMany() before being merged into the collection, when no sort key is
+// available for the comparator
+static const int PARALLEL_SORT_THRESHOLD = 8192;
+
+// Low bits of a packed sort key hold the tiebreaking DataObjectNumber; numbers
+// beyond what fits saturate, and the comparator settles such ties
+static const int TIEBREAK_BITS = 20;
+static const quint64 TIEBREAK_MASK = (Q_UINT64_C(1) << TIEBREAK_BITS) - 1;
+static const qint64 VALUE_BIAS = Q_INT64_C(1) << (63 - TIEBREAK_BITS);
+
+/*!
+ * \brief The SortKeyRegistration struct
+ */
+struct SortKeyRegistration
+{
+    DataObjectComparator comparator;
+    DataObjectSortKey sortKey;
+};
+
+/*!
+ * \brief sortKeyRegistrations
+ * \return the comparators which have a sort key registered
+ */
+static QList<SortKeyRegistration>& sortKeyRegistrations()
+{
+    static QList<SortKeyRegistration> registrations;
+
+    return registrations;
+}
+
+/*!
+ * \brief The SortEntryLessThan class
+ * Orders DataSortEntries by key, falling back on the comparator for equal keys
+ */
+class SortEntryLessThan
+{
+public:
+    explicit SortEntryLessThan(DataObjectComparator comparator)
+        : m_comparator(comparator)
+    {
+    }
+
+    bool operator()(const DataSortEntry& a, const DataSortEntry& b) const
+    {
+        return (a.key != b.key) ? (a.key < b.key) : m_comparator(a.object, b.object);
+    }
+
+private:
+    DataObjectComparator m_comparator;
+};
+
+/*!
+ * \brief The SortChunk struct
+ * A slice of a batch being sorted or merged on a worker thread
+ */
+struct SortChunk
+{
+    DataSortEntry* begin;
+    DataSortEntry* middle;
+    DataSortEntry* end;
+    DataObjectComparator comparator;
+};
+
+/*!
+ * \brief sortChunk
+ * \param chunk
+ */
+static void sortChunk(SortChunk& chunk)
+{
+    std::stable_sort(chunk.begin, chunk.end, SortEntryLessThan(chunk.comparator));
+}
+
+/*!
+ * \brief mergeChunk merges the two sorted halves of a chunk
+ * \param chunk
+ */
+static void mergeChunk(SortChunk& chunk)
+{
+    std::inplace_merge(chunk.begin, chunk.middle, chunk.end,
+                       SortEntryLessThan(chunk.comparator));
+}
+
+/*!
+ * \brief radixSort
+ * Stable LSD radix sort on the entries' keys, one byte per pass; passes where
+ * every key holds the same byte are skipped
+ * \param entries
+ */
+static void radixSort(QVector<DataSortEntry>* entries)
+{
+    int count = entries->count();
+    if (count < 2)
+        return;
+
+    QVector<DataSortEntry> buffer(count);
+    DataSortEntry* from = entries->data();
+    DataSortEntry* to = buffer.data();
+
+    for (int shift = 0; shift < 64; shift += 8) {
+        int offsets[256] = { 0 };
+        for (int i = 0; i < count; ++i)
+            offsets[(from[i].key >> shift) & 0xff]++;
+
+        if (offsets[(from[0].key >> shift) & 0xff] == count)
+            continue;
+
+        int offset = 0;
+        for (int digit = 0; digit < 256; ++digit) {
+            int digitCount = offsets[digit];
+            offsets[digit] = offset;
+            offset += digitCount;
+        }
+
+        for (int i = 0; i < count; ++i)
+            to[offsets[(from[i].key >> shift) & 0xff]++] = from[i];
+
+        qSwap(from, to);
+    }
+
+    if (from != entries->data())
+        std::copy(from, from + count, entries->data());
+}
+
+/*!
+ * \brief DataCollectionDelta::appendIndex
+ * Extends the last range if the index follows on from it (in either
+ * direction), otherwise starts a new one
+ * \param ranges
+ * \param index
+ */
+void DataCollectionDelta::appendIndex(QList<DataIndexRange>* ranges, int index)
+{
+    if (!ranges->isEmpty()) {
+        DataIndexRange& last = ranges->last();
+        if (last.second == index - 1) {
+            last.second = index;
+
+            return;
+        }
+
+        if (last.first == index + 1) {
+            last.first = index;
+
+            return;
+        }
+    }
+
+    ranges->append(DataIndexRange(index, index));
+}
 
 /*!
  * \brief DataCollection::DataCollection
  * \param name
  */
 DataCollection::DataCollection(const QString& name)
-    : m_name(name.toUtf8()), m_comparator(defaultDataObjectComparator)
+    : m_name(name.toUtf8()), m_comparator(defaultDataObjectComparator),
+      m_sortKey(defaultDataObjectSortKey)
 {
     // All DataCollections are registered as C++ ownership; QML should never GC them
     QQmlEngine::setObjectOwnership(this, QQmlEngine::CppOwnership);
@@ -44,6 +201,16 @@ void DataCollection::notifyContentsToBeChanged(const QSet<DataObject*>* added,
     emit contentsAboutToBeChanged(added, removed);
 }
 
+/*!
+ * \brief DataCollection::notifyContentsRangesChanged
+ * \param delta
+ * \param notify
+ */
+void DataCollection::notifyContentsRangesChanged(const DataCollectionDelta* delta, bool notify)
+{
+    emit contentsRangesChanged(delta, notify);
+}
+
 /*!
  * \brief DataCollection::notifyContentsChanged
  * \param added
@@ -61,6 +228,14 @@ void DataCollection::notifyContentDataChanged(DataObject* object)
     emit contentDataChanged(object);
 }
 
+/*!
+ * \brief DataCollection::notifyOrderingToBeChanged
+ */
+void DataCollection::notifyOrderingToBeChanged()
+{
+    emit orderingAboutToBeChanged();
+}
+
 /*!
  * \brief DataCollection::notifyOrderingChanged
  */
@@ -98,9 +273,13 @@ void DataCollection::add(DataObject* object)
 
     // Cheaper to binary insert single item than append it to list and do a
     // complete re-sort
-    binaryListInsert(object);
+    int index = binaryListInsert(object);
     m_set.insert(object);
 
+    DataCollectionDelta delta;
+    delta.inserted.append(DataIndexRange(index, index));
+
+    notifyContentsRangesChanged(&delta, true);
     notifyContentsChanged(&to_add, NULL, true);
 
     sanity();
@@ -133,13 +312,16 @@ void DataCollection::addMany(const QSet<DataObject*>& objects)
 
     notifyContentsToBeChanged(&to_add, NULL);
 
-    foreach (object, to_add) {
-        // Cheaper to binary insert single item than append it to list and do a
-        // complete re-sort
-        binaryListInsert(object);
-        m_set.insert(object);
-    }
+    // Sort the batch once and merge it in a single pass rather than binary
+    // inserting each object, which shifts the list once per object
+    QVector<DataSortEntry> batch = sortEntries(to_add.toList());
+    sortBatch(&batch);
+
+    DataCollectionDelta delta;
+    mergeSortedBatch(batch, &delta.inserted);
+    m_set.unite(to_add);
 
+    notifyContentsRangesChanged(&delta, true);
     notifyContentsChanged(&to_add, NULL, true);
 
     sanity();
@@ -161,12 +343,23 @@ void DataCollection::remove(DataObject* object, bool notify)
 
     notifyContentsToBeChanged(NULL, &to_remove);
 
+    int index = findIndex(object);
+    Q_ASSERT(index >= 0);
+
+    m_list.removeAt(index);
+    if (m_sortKey != NULL) {
+        m_keys.remove(index);
+        m_cachedKeys.remove(object);
+    }
+
     bool removed = m_set.remove(object);
     Q_ASSERT(removed);
-    removed = m_list.removeOne(object);
-    Q_ASSERT(removed);
     Q_UNUSED(removed);
 
+    DataCollectionDelta delta;
+    delta.removed.append(DataIndexRange(index, index));
+
+    notifyContentsRangesChanged(&delta, notify);
     notifyContentsChanged(NULL, &to_remove, notify);
 
     sanity();
@@ -204,14 +397,35 @@ void DataCollection::removeMany(const QSet<DataObject *> &objects, bool notify)
 
     notifyContentsToBeChanged(NULL, &to_remove);
 
-    foreach (object, to_remove) {
-        bool removed = m_list.removeOne(object);
-        Q_ASSERT(removed);
-        Q_UNUSED(removed);
+    // Compact the list in a single pass rather than searching for and
+    // removing each object in turn
+    DataCollectionDelta delta;
+    int kept = 0;
+    for (int index = m_list.count() - 1; index >= 0; --index) {
+        if (to_remove.contains(m_list[index]))
+            DataCollectionDelta::appendIndex(&delta.removed, index);
+    }
+
+    for (int index = 0; index < m_list.count(); ++index) {
+        if (to_remove.contains(m_list[index]))
+            continue;
+
+        m_list[kept] = m_list[index];
+        if (m_sortKey != NULL)
+            m_keys[kept] = m_keys[index];
+        ++kept;
+    }
+
+    m_list.erase(m_list.begin() + kept, m_list.end());
+    if (m_sortKey != NULL) {
+        m_keys.resize(kept);
+        foreach (object, to_remove)
+            m_cachedKeys.remove(object);
     }
 
     m_set.subtract(to_remove);
 
+    notifyContentsRangesChanged(&delta, notify);
     notifyContentsChanged(NULL, &to_remove, notify);
 
     sanity();
@@ -233,9 +447,15 @@ void DataCollection::clear()
 
     notifyContentsToBeChanged(NULL, &all);
 
+    DataCollectionDelta delta;
+    delta.removed.append(DataIndexRange(0, m_list.count() - 1));
+
     m_list.clear();
+    m_keys.clear();
+    m_cachedKeys.clear();
     m_set.clear();
 
+    notifyContentsRangesChanged(&delta, true);
     notifyContentsChanged(NULL, &all, true);
 
     sanity();
@@ -299,7 +519,7 @@ int DataCollection::indexOf(DataObject* object) const
     if (!m_set.contains(object))
         return -1;
 
-    int index = m_list.indexOf(object);
+    int index = findIndex(object);
 
     // Testing with set_ should prevent this possibility
     Q_ASSERT(index >= 0);
@@ -317,6 +537,7 @@ void DataCollection::setComparator(DataObjectComparator comparator)
         return;
 
     m_comparator = (comparator != NULL) ? comparator : defaultDataObjectComparator;
+    m_sortKey = sortKeyFor(m_comparator);
 
     resort(true);
 }
@@ -330,6 +551,158 @@ DataObjectComparator DataCollection::comparator() const
     return m_comparator;
 }
 
+/*!
+ * \brief DataCollection::sortKey
+ * \return the sort key registered for the comparator, or NULL
+ */
+DataObjectSortKey DataCollection::sortKey() const
+{
+    return m_sortKey;
+}
+
+/*!
+ * \brief DataCollection::refreshSortKey
+ * Must be called when a DataObject's sort key may have changed, e.g. after
+ * its exposure time was updated.  The object is found under the key it was
+ * filed with and binary inserted again under the new one; if that moves it,
+ * the move is reported as a removal and an insertion of the one index.
+ * \param object
+ */
+void DataCollection::refreshSortKey(DataObject* object)
+{
+    if (m_sortKey == NULL || !m_set.contains(object))
+        return;
+
+    if (m_sortKey(object) == m_cachedKeys.value(object))
+        return;
+
+    int index = findIndex(object);
+    Q_ASSERT(index >= 0);
+
+    m_list.removeAt(index);
+    m_keys.remove(index);
+    int new_index = binaryListInsert(object);
+
+    sanity();
+
+    if (new_index == index)
+        return;
+
+    DataCollectionDelta delta;
+    delta.removed.append(DataIndexRange(index, index));
+    delta.inserted.append(DataIndexRange(new_index, new_index));
+    delta.moved = true;
+
+    notifyContentsRangesChanged(&delta, true);
+}
+
+/*!
+ * \brief DataCollection::reorderLike
+ * Installs the comparator of another collection which holds (at least) all
+ * of this collection's objects, taking the order straight from that
+ * collection rather than re-sorting.
+ * \param ordered
+ */
+void DataCollection::reorderLike(const DataCollection* ordered)
+{
+    Q_ASSERT(ordered != NULL);
+
+    m_comparator = ordered->m_comparator;
+    m_sortKey = ordered->m_sortKey;
+
+    if (!ordered->m_set.contains(m_set)) {
+        qWarning("%s can't take its ordering from %s", toString(), ordered->toString());
+        resort(true);
+
+        return;
+    }
+
+    notifyOrderingToBeChanged();
+
+    QList<DataObject*> list;
+    list.reserve(count());
+    QVector<quint64> keys;
+    if (m_sortKey != NULL)
+        keys.reserve(count());
+
+    for (int index = 0; index < ordered->count() && list.count() < count(); ++index) {
+        DataObject* object = ordered->m_list[index];
+        if (!m_set.contains(object))
+            continue;
+
+        list.append(object);
+        if (m_sortKey != NULL)
+            keys.append(ordered->m_keys[index]);
+    }
+
+    m_list = list;
+    m_keys = keys;
+    cacheKeys();
+
+    sanity();
+
+    notifyOrderingChanged();
+}
+
+/*!
+ * \brief DataCollection::registerSortKey
+ * Installs a sort key for a comparator; collections that have the comparator
+ * set afterwards cache the key for each DataObject and compare the keys
+ * rather than calling the comparator.
+ * \param comparator
+ * \param sortKey
+ */
+void DataCollection::registerSortKey(DataObjectComparator comparator, DataObjectSortKey sortKey)
+{
+    if (sortKeyFor(comparator) != NULL)
+        return;
+
+    SortKeyRegistration registration = { comparator, sortKey };
+    sortKeyRegistrations().append(registration);
+}
+
+/*!
+ * \brief DataCollection::sortKeyFor
+ * \param comparator
+ * \return the sort key registered for the comparator, or NULL if there is none
+ */
+DataObjectSortKey DataCollection::sortKeyFor(DataObjectComparator comparator)
+{
+    if (comparator == defaultDataObjectComparator)
+        return defaultDataObjectSortKey;
+
+    foreach (const SortKeyRegistration& registration, sortKeyRegistrations()) {
+        if (registration.comparator == comparator)
+            return registration.sortKey;
+    }
+
+    return NULL;
+}
+
+/*!
+ * \brief DataCollection::packedSortKey
+ * Packs a value (a time in milliseconds, a file size, ...) and a
+ * DataObjectNumber tiebreak into a sort key: the upper bits hold the biased
+ * value and the lower bits the number.  Numbers too large for the tiebreak
+ * bits all pack to the same value, so only objects with equal keys need to be
+ * compared any further.
+ * \param value clamped to +/- 2^43
+ * \param tiebreaker
+ * \param ascendingTiebreak true if lower numbers should sort first
+ * \return
+ */
+quint64 DataCollection::packedSortKey(qint64 value, DataObject* tiebreaker,
+                                      bool ascendingTiebreak)
+{
+    quint64 biased = (quint64) (qBound(-VALUE_BIAS, value, VALUE_BIAS - 1) + VALUE_BIAS);
+
+    quint64 tiebreak = (quint64) qBound(0, tiebreaker->number(), (int) TIEBREAK_MASK);
+    if (!ascendingTiebreak)
+        tiebreak = TIEBREAK_MASK - tiebreak;
+
+    return (biased << TIEBREAK_BITS) | tiebreak;
+}
+
 /*!
  * \brief DataCollection::defaultDataObjectComparator
  * Default comparator uses DataObjectNumber
@@ -346,20 +719,35 @@ bool DataCollection::defaultDataObjectComparator(DataObject* a, DataObject* b)
     return a->number() < b->number();
 }
 
+/*!
+ * \brief DataCollection::defaultDataObjectSortKey
+ * \param object
+ * \return the DataObjectNumber, biased to be unsigned
+ */
+quint64 DataCollection::defaultDataObjectSortKey(DataObject* object)
+{
+    return (quint64) ((qint64) object->number() - (qint64) INT_MIN);
+}
+
 /*!
  * \brief DataCollection::const
  */
 void DataCollection::sanity() const
 {
     Q_ASSERT(m_list.count() == m_set.count());
+    Q_ASSERT(m_sortKey == NULL || m_keys.count() == m_list.count());
+    Q_ASSERT(m_sortKey == NULL || m_cachedKeys.count() == m_list.count());
 }
 
 /*!
  * \brief DataCollection::binaryListInsert
  * \param object
+ * \return the index the object was inserted at
  */
-void DataCollection::binaryListInsert(DataObject* object)
+int DataCollection::binaryListInsert(DataObject* object)
 {
+    DataSortEntry entry = { (m_sortKey != NULL) ? m_sortKey(object) : 0, object };
+
     int index = -1;
 
     int low = 0;
@@ -372,12 +760,12 @@ void DataCollection::binaryListInsert(DataObject* object)
         }
 
         int mid = low + ((high - low) / 2);
-        DataObject* midObject = m_list[mid];
+        DataSortEntry midEntry = { (m_sortKey != NULL) ? m_keys[mid] : 0, m_list[mid] };
 
-        if (m_comparator(object, midObject)) {
+        if (lessThan(entry, mid)) {
             // lowerThan
             high = mid;
-        } else if (m_comparator(midObject, object)) {
+        } else if (SortEntryLessThan(m_comparator)(midEntry, entry)) {
             // higherThan
             low = mid + 1;
         } else {
@@ -391,6 +779,200 @@ void DataCollection::binaryListInsert(DataObject* object)
     Q_ASSERT(index >= 0 && index <= m_list.count());
 
     m_list.insert(index, object);
+    if (m_sortKey != NULL) {
+        m_keys.insert(index, entry.key);
+        m_cachedKeys.insert(object, entry.key);
+    }
+
+    return index;
+}
+
+/*!
+ * \brief DataCollection::mergeSortedBatch
+ * Merges a batch already sorted by the current comparator into the list.  Each
+ * object's slot is found with a binary search over the part of the list not
+ * yet merged, so small batches cost O(k log n) comparisons; the list itself
+ * is only copied once.
+ * \param batch
+ * \param inserted receives the contiguous ranges the batch lands in
+ */
+void DataCollection::mergeSortedBatch(const QVector<DataSortEntry>& batch,
+                                      QList<DataIndexRange>* inserted)
+{
+    QList<DataObject*> merged;
+    merged.reserve(m_list.count() + batch.count());
+
+    QVector<quint64> mergedKeys;
+    if (m_sortKey != NULL)
+        mergedKeys.reserve(m_list.count() + batch.count());
+
+    int next = 0;
+    foreach (const DataSortEntry& entry, batch) {
+        // upper bound of the entry in the unmerged part of the list
+        int low = next;
+        int high = m_list.count();
+        while (low < high) {
+            int mid = low + ((high - low) / 2);
+            if (lessThan(entry, mid))
+                high = mid;
+            else
+                low = mid + 1;
+        }
+
+        for (; next < low; ++next) {
+            merged.append(m_list[next]);
+            if (m_sortKey != NULL)
+                mergedKeys.append(m_keys[next]);
+        }
+
+        int index = merged.count();
+        merged.append(entry.object);
+        if (m_sortKey != NULL) {
+            mergedKeys.append(entry.key);
+            m_cachedKeys.insert(entry.object, entry.key);
+        }
+
+        DataCollectionDelta::appendIndex(inserted, index);
+    }
+
+    for (; next < m_list.count(); ++next) {
+        merged.append(m_list[next]);
+        if (m_sortKey != NULL)
+            mergedKeys.append(m_keys[next]);
+    }
+
+    m_list = merged;
+    m_keys = mergedKeys;
+}
+
+/*!
+ * \brief DataCollection::sortBatch
+ * Sorts a batch into the current order.  With a sort key this is a radix sort
+ * on the keys, leaving only runs of equal keys for the comparator.  Without
+ * one, large batches are split into one chunk per core, sorted in parallel and
+ * then merged pairwise.
+ * \param batch
+ */
+void DataCollection::sortBatch(QVector<DataSortEntry>* batch) const
+{
+    SortEntryLessThan entryLessThan(m_comparator);
+
+    if (m_sortKey != NULL) {
+        radixSort(batch);
+
+        DataSortEntry* entries = batch->data();
+        int count = batch->count();
+        for (int first = 0; first < count;) {
+            int last = first + 1;
+            while (last < count && entries[last].key == entries[first].key)
+                ++last;
+
+            if (last - first > 1)
+                std::stable_sort(entries + first, entries + last, entryLessThan);
+
+            first = last;
+        }
+
+        return;
+    }
+
+    int threads = QThread::idealThreadCount();
+    if (batch->count() < PARALLEL_SORT_THRESHOLD || threads < 2) {
+        std::stable_sort(batch->begin(), batch->end(), entryLessThan);
+
+        return;
+    }
+
+    DataSortEntry* begin = batch->data();
+    int chunkSize = (batch->count() + threads - 1) / threads;
+
+    QList<SortChunk> chunks;
+    for (int start = 0; start < batch->count(); start += chunkSize) {
+        SortChunk chunk;
+        chunk.begin = begin + start;
+        chunk.end = begin + qMin(start + chunkSize, batch->count());
+        chunk.middle = chunk.end;
+        chunk.comparator = m_comparator;
+        chunks.append(chunk);
+    }
+
+    QtConcurrent::blockingMap(chunks, sortChunk);
+
+    // Merge neighbouring chunks until a single sorted run remains
+    while (chunks.count() > 1) {
+        QList<SortChunk> pairs;
+        for (int i = 0; i + 1 < chunks.count(); i += 2) {
+            SortChunk pair = chunks[i];
+            pair.middle = chunks[i].end;
+            pair.end = chunks[i + 1].end;
+            pairs.append(pair);
+        }
+
+        QtConcurrent::blockingMap(pairs, mergeChunk);
+
+        // an odd chunk out is carried over untouched to the next round
+        if (chunks.count() % 2 != 0)
+            pairs.append(chunks.last());
+
+        chunks = pairs;
+    }
+}
+
+/*!
+ * \brief DataCollection::sortEntries
+ * \param objects
+ * \return the objects paired with their sort keys (all zero if no sort key is
+ * registered for the comparator)
+ */
+QVector<DataSortEntry> DataCollection::sortEntries(const QList<DataObject*>& objects) const
+{
+    QVector<DataSortEntry> entries(objects.count());
+    for (int i = 0; i < objects.count(); ++i) {
+        entries[i].key = (m_sortKey != NULL) ? m_sortKey(objects[i]) : 0;
+        entries[i].object = objects[i];
+    }
+
+    return entries;
+}
+
+/*!
+ * \brief DataCollection::lessThan
+ * \param entry
+ * \param index
+ * \return true if the entry sorts before the object at the index
+ */
+bool DataCollection::lessThan(const DataSortEntry& entry, int index) const
+{
+    if (m_sortKey != NULL && entry.key != m_keys[index])
+        return entry.key < m_keys[index];
+
+    return m_comparator(entry.object, m_list[index]);
+}
+
+/*!
+ * \brief DataCollection::findIndex
+ * With a sort key the object is located by binary search over the cached
+ * keys, using the key it was filed with even if its sort data has changed
+ * since; otherwise the list is scanned.
+ * \param object
+ * \return
+ */
+int DataCollection::findIndex(DataObject* object) const
+{
+    QHash<DataObject*, quint64>::const_iterator cached = m_cachedKeys.constFind(object);
+    if (m_sortKey != NULL && cached != m_cachedKeys.constEnd()) {
+        quint64 key = cached.value();
+
+        QVector<quint64>::const_iterator it =
+            std::lower_bound(m_keys.constBegin(), m_keys.constEnd(), key);
+        for (int index = it - m_keys.constBegin();
+             index < m_keys.count() && m_keys[index] == key; ++index) {
+            if (m_list[index] == object)
+                return index;
+        }
+    }
+
+    return m_list.indexOf(object);
 }
 
 /*!
@@ -399,15 +981,54 @@ void DataCollection::binaryListInsert(DataObject* object)
  */
 void DataCollection::resort(bool fire_signal)
 {
-    if (count() <= 1)
+    if (count() <= 1) {
+        // keep the (at most one) cached key in step with the comparator
+        m_keys.clear();
+        if (m_sortKey != NULL && count() == 1)
+            m_keys.append(m_sortKey(m_list[0]));
+        cacheKeys();
+
         return;
+    }
+
+    if (fire_signal)
+        notifyOrderingToBeChanged();
+
+    if (m_sortKey != NULL) {
+        QVector<DataSortEntry> entries = sortEntries(m_list);
+        sortBatch(&entries);
 
-    qSort(m_list.begin(), m_list.end(), m_comparator);
+        m_keys.resize(entries.count());
+        for (int i = 0; i < entries.count(); ++i) {
+            m_list[i] = entries[i].object;
+            m_keys[i] = entries[i].key;
+        }
+    } else {
+        m_keys.clear();
+        qSort(m_list.begin(), m_list.end(), m_comparator);
+    }
+    cacheKeys();
 
     if (fire_signal)
         notifyOrderingChanged();
 }
 
+/*!
+ * \brief DataCollection::cacheKeys
+ * Files every object under its key in m_keys, after they have all been
+ * keyed afresh
+ */
+void DataCollection::cacheKeys()
+{
+    m_cachedKeys.clear();
+    if (m_sortKey == NULL)
+        return;
+
+    m_cachedKeys.reserve(m_list.count());
+    for (int index = 0; index < m_list.count(); ++index)
+        m_cachedKeys.insert(m_list[index], m_keys[index]);
+}
+
 /*!
  * \brief DataCollection::setInternalName
  * \param name
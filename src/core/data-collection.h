@@ -24,16 +24,55 @@
 #include "collections.h"
 
 #include <QByteArray>
+#include <QHash>
 #include <QList>
 #include <QObject>
+#include <QPair>
 #include <QSet>
 #include <QString>
+#include <QVector>
 
 class DataObject;
 
 // Defined as a LessThan comparator (return true if a is less than b)
 typedef bool (*DataObjectComparator)(DataObject* a, DataObject* b);
 
+// Maps a DataObject to a key whose natural ordering agrees with a
+// DataObjectComparator: if key(a) < key(b) then comparator(a, b) must hold.
+// Objects with equal keys are ordered by the comparator itself.
+typedef quint64 (*DataObjectSortKey)(DataObject* object);
+
+// A DataObject paired with its sort key, as held while sorting and merging
+struct DataSortEntry
+{
+    quint64 key;
+    DataObject* object;
+};
+Q_DECLARE_TYPEINFO(DataSortEntry, Q_PRIMITIVE_TYPE);
+
+// A contiguous run of indexes in a DataCollection, first and last inclusive
+typedef QPair<int, int> DataIndexRange;
+
+/**
+  * Describes a change to a DataCollection's contents as runs of indexes.
+  * The removed ranges are indexes before the change, in descending order; the
+  * inserted ranges are indexes after the change, in ascending order.  Applying
+  * the removals and then the insertions in that order turns the old list into
+  * the new one.  A delta marked as moved takes nothing out of the collection:
+  * the inserted ranges hold the very objects of the removed ones, in the same
+  * order, which have only changed position.
+  */
+struct DataCollectionDelta
+{
+    DataCollectionDelta() : moved(false) { }
+
+    QList<DataIndexRange> removed;
+    QList<DataIndexRange> inserted;
+    bool moved;
+
+    static void appendIndex(QList<DataIndexRange>* ranges, int index);
+};
+
 /**
   * A DataCollection is a heavyweight, fully signalled collection class.  It is
   * not intended for general use but rather to hold core data structures that
@@ -50,6 +89,11 @@ signals:
     void contentsAboutToBeChanged(const QSet<DataObject*>* added,
                                   const QSet<DataObject*>* removed);
 
+    // fired *after* the DataObjects have been added or removed from the
+    // collection but before contentsChanged, describing where they were
+    // removed from and inserted at
+    void contentsRangesChanged(const DataCollectionDelta* delta, bool notify);
+
     // fired *after* the DataObjects have been added or removed from the collection
     void contentsChanged(const QSet<DataObject*>* added,
                           const QSet<DataObject*>* removed,
@@ -57,6 +101,10 @@ signals:
 
     void contentDataChanged(DataObject* object);
 
+    // fired before the DataCollection is reordered, while the DataObjects are
+    // still at their old indexes
+    void orderingAboutToBeChanged();
+
     // fired after the the DataCollection has been reordered due to a new
     // DataObjectComparator being installed; if the new comparator doesn't
     // actually affect the ordering, this signal will still be called
@@ -64,6 +112,11 @@ signals:
 
 public:
     static bool defaultDataObjectComparator(DataObject* a, DataObject* b);
+    static quint64 defaultDataObjectSortKey(DataObject* object);
+
+    static void registerSortKey(DataObjectComparator comparator, DataObjectSortKey sortKey);
+    static DataObjectSortKey sortKeyFor(DataObjectComparator comparator);
+    static quint64 packedSortKey(qint64 value, DataObject* tiebreaker, bool ascendingTiebreak);
 
     DataCollection(const QString& name);
 
@@ -101,32 +154,51 @@ public:
 
     void setComparator(DataObjectComparator comparator);
     DataObjectComparator comparator() const;
+    DataObjectSortKey sortKey() const;
+    void refreshSortKey(DataObject* object);
 
     void setInternalName(const QString& name);
 
     virtual const char* toString() const;
 
 protected:
+    void reorderLike(const DataCollection* ordered);
+
     virtual void notifyContentsToBeChanged(const QSet<DataObject*>* added,
                                            const QSet<DataObject*>* removed);
 
+    virtual void notifyContentsRangesChanged(const DataCollectionDelta* delta, bool notify);
+
     virtual void notifyContentsChanged(const QSet<DataObject*>* added,
                                        const QSet<DataObject*>* removed,
                                        bool notify);
 
     virtual void notifyContentDataChanged(DataObject* object);
 
+    virtual void notifyOrderingToBeChanged();
+
     virtual void notifyOrderingChanged();
 
 private:
     void sanity() const;
-    void binaryListInsert(DataObject* object);
+    int binaryListInsert(DataObject* object);
+    void mergeSortedBatch(const QVector<DataSortEntry>& batch, QList<DataIndexRange>* inserted);
+    void sortBatch(QVector<DataSortEntry>* batch) const;
+    QVector<DataSortEntry> sortEntries(const QList<DataObject*>& objects) const;
+    bool lessThan(const DataSortEntry& a, int index) const;
+    int findIndex(DataObject* object) const;
     void resort(bool fire_signal);
+    void cacheKeys();
 
     QByteArray m_name;
     QList<DataObject*> m_list;
     QSet<DataObject*> m_set;
     DataObjectComparator m_comparator;
+    DataObjectSortKey m_sortKey;
+    QVector<quint64> m_keys;
+    // the key each object is filed under in m_keys, which stays findable
+    // after the object's sort data has changed
+    QHash<DataObject*, quint64> m_cachedKeys;
 };
 
 #endif  // GALLERY_DATA_COLLECTION_H_
@@ -24,7 +24,7 @@
  * \param name
  */
 SelectableViewCollection::SelectableViewCollection(const QString& name)
-    : ViewCollection(name), m_monitoringSelection(NULL)
+    : ViewCollection(name), m_selectedValid(true), m_monitoringSelection(NULL)
 {
 }
 
@@ -36,12 +36,77 @@ SelectableViewCollection::SelectableViewCollection(const QString& name)
 void SelectableViewCollection::notifyContentsToBeChanged(const QSet<DataObject*>* added,
                                                              const QSet<DataObject*>* removed)
 {
-    if (removed != NULL)
+    if (removed != NULL && m_selection.count() > 0)
         unselectMany(*removed);
 
     ViewCollection::notifyContentsToBeChanged(added, removed);
 }
 
+/*!
+ * \brief SelectableViewCollection::notifyContentsRangesChanged
+ * Keeps the selection bits aligned with the DataObjects they belong to; the
+ * removed objects have already been unselected and the added ones start off
+ * unselected, except for moved objects, which take their bits with them
+ * \param delta
+ * \param notify
+ */
+void SelectableViewCollection::notifyContentsRangesChanged(const DataCollectionDelta* delta,
+                                                           bool notify)
+{
+    // the bits of moved objects, in the order the objects come in
+    QList<bool> moved_bits;
+    if (delta->moved) {
+        foreach (const DataIndexRange& range, delta->removed) {
+            for (int index = range.second; index >= range.first; --index)
+                moved_bits.prepend(m_selection.testBit(index));
+        }
+    }
+
+    m_selection.removeRanges(delta->removed);
+    m_selection.insertRanges(delta->inserted);
+    Q_ASSERT(m_selection.size() == count());
+
+    if (delta->moved) {
+        int next = 0;
+        foreach (const DataIndexRange& range, delta->inserted) {
+            for (int index = range.first; index <= range.second; ++index)
+                m_selection.setBit(index, moved_bits.value(next++));
+        }
+    }
+
+    ViewCollection::notifyContentsRangesChanged(delta, notify);
+}
+
+/*!
+ * \brief SelectableViewCollection::notifyOrderingToBeChanged
+ */
+void SelectableViewCollection::notifyOrderingToBeChanged()
+{
+    if (m_selection.count() > 0)
+        m_reordering = getSelected();
+
+    ViewCollection::notifyOrderingToBeChanged();
+}
+
+/*!
+ * \brief SelectableViewCollection::notifyOrderingChanged
+ * The selected DataObjects have moved, so their bits are laid out again
+ */
+void SelectableViewCollection::notifyOrderingChanged()
+{
+    if (!m_reordering.isEmpty()) {
+        m_selection.setRange(0, count() - 1, false);
+        for (int index = 0; index < count(); ++index) {
+            if (m_reordering.contains(getAt(index)))
+                m_selection.setBit(index, true);
+        }
+
+        m_reordering.clear();
+    }
+
+    ViewCollection::notifyOrderingChanged();
+}
+
 /*!
  * \brief SelectableViewCollection::notifySelectionChanged
  * \param selected
@@ -53,6 +118,35 @@ void SelectableViewCollection::notifySelectionChanged(QSet<DataObject*>* selecte
     emit selectionChanged(selected, unselected);
 }
 
+/*!
+ * \brief SelectableViewCollection::notifySelectionRangesChanged
+ * The ranges are always reported; the DataObjects in them are only gathered
+ * into a set if anyone is listening for one
+ * \param ranges
+ * \param selected
+ */
+void SelectableViewCollection::notifySelectionRangesChanged(const QList<DataIndexRange>* ranges,
+                                                            bool selected)
+{
+    m_selectedValid = false;
+
+    emit selectionRangesChanged(ranges, selected);
+
+    if (receivers(SIGNAL(selectionChanged(const QSet<DataObject*>*, const QSet<DataObject*>*))) == 0)
+        return;
+
+    QSet<DataObject*> changed;
+    foreach (const DataIndexRange& range, *ranges) {
+        for (int index = range.first; index <= range.second; ++index)
+            changed.insert(getAt(index));
+    }
+
+    if (selected)
+        notifySelectionChanged(&changed, NULL);
+    else
+        notifySelectionChanged(NULL, &changed);
+}
+
 /*!
  * \brief SelectableViewCollection::isSelected
  * \param object
@@ -60,7 +154,22 @@ void SelectableViewCollection::notifySelectionChanged(QSet<DataObject*>* selecte
  */
 bool SelectableViewCollection::isSelected(DataObject* object) const
 {
-    return m_selected.contains(object);
+    if (m_selectedValid)
+        return m_selected.contains(object);
+
+    int index = indexOf(object);
+
+    return index >= 0 && m_selection.testBit(index);
+}
+
+/*!
+ * \brief SelectableViewCollection::isSelectedAt
+ * \param index
+ * \return
+ */
+bool SelectableViewCollection::isSelectedAt(int index) const
+{
+    return index >= 0 && index < m_selection.size() && m_selection.testBit(index);
 }
 
 /*!
@@ -69,6 +178,18 @@ bool SelectableViewCollection::isSelected(DataObject* object) const
  */
 const QSet<DataObject*>& SelectableViewCollection::getSelected() const
 {
+    if (!m_selectedValid) {
+        m_selected.clear();
+        m_selected.reserve(m_selection.count());
+
+        foreach (const BitSet::Range& range, m_selection.runs(0, count() - 1, true)) {
+            for (int index = range.first; index <= range.second; ++index)
+                m_selected.insert(getAt(index));
+        }
+
+        m_selectedValid = true;
+    }
+
     return m_selected;
 }
 
@@ -78,7 +199,23 @@ const QSet<DataObject*>& SelectableViewCollection::getSelected() const
  */
 int SelectableViewCollection::selectedCount() const
 {
-    return m_selected.count();
+    return m_selection.count();
+}
+
+/*!
+ * \brief SelectableViewCollection::selectedCount
+ * \param first
+ * \param last
+ * \return the number of selected DataObjects between first and last
+ */
+int SelectableViewCollection::selectedCount(int first, int last) const
+{
+    first = qMax(first, 0);
+    last = qMin(last, count() - 1);
+    if (first > last)
+        return 0;
+
+    return m_selection.count(first, last);
 }
 
 /*!
@@ -89,17 +226,11 @@ int SelectableViewCollection::selectedCount() const
  */
 bool SelectableViewCollection::select(DataObject* object)
 {
-    if (!contains(object) || m_selected.contains(object))
+    int index = indexOf(object);
+    if (index < 0)
         return false;
 
-    m_selected.insert(object);
-
-    QSet<DataObject*> singleton;
-    singleton.insert(object);
-
-    notifySelectionChanged(&singleton, NULL);
-
-    return true;
+    return setRangeSelected(index, index, true) > 0;
 }
 
 /*!
@@ -110,19 +241,11 @@ bool SelectableViewCollection::select(DataObject* object)
  */
 bool SelectableViewCollection::unselect(DataObject* object)
 {
-    if (!contains(object) || !m_selected.contains(object))
+    int index = indexOf(object);
+    if (index < 0)
         return false;
 
-    bool removed = m_selected.remove(object);
-    Q_ASSERT(removed);
-    Q_UNUSED(removed);
-
-    QSet<DataObject*> singleton;
-    singleton.insert(object);
-
-    notifySelectionChanged(NULL, &singleton);
-
-    return true;
+    return setRangeSelected(index, index, false) > 0;
 }
 
 /*!
@@ -132,7 +255,11 @@ bool SelectableViewCollection::unselect(DataObject* object)
  */
 bool SelectableViewCollection::toggleSelect(DataObject* object)
 {
-    return isSelected(object) ? unselect(object) : select(object);
+    int index = indexOf(object);
+    if (index < 0)
+        return false;
+
+    return setRangeSelected(index, index, !m_selection.testBit(index)) > 0;
 }
 
 /*!
@@ -141,7 +268,7 @@ bool SelectableViewCollection::toggleSelect(DataObject* object)
  */
 int SelectableViewCollection::selectAll()
 {
-    return selectMany(getAsSet());
+    return selectRange(0, count() - 1);
 }
 
 /*!
@@ -151,20 +278,18 @@ int SelectableViewCollection::selectAll()
  */
 int SelectableViewCollection::selectMany(const QSet<DataObject*>& select)
 {
-    // Only select objects not already selected
-    QSet<DataObject*> selected;
-    DataObject* object;
-    foreach (object, select) {
-        if (contains(object) && !isSelected(object)) {
-            m_selected.insert(object);
-            selected.insert(object);
-        }
-    }
-
-    if (selected.count() > 0)
-        notifySelectionChanged(&selected, NULL);
+    return setSelected(select, true);
+}
 
-    return selected.count();
+/*!
+ * \brief SelectableViewCollection::selectRange
+ * \param first
+ * \param last
+ * \return Returns the number of items selected (that weren't selected before)
+ */
+int SelectableViewCollection::selectRange(int first, int last)
+{
+    return setRangeSelected(first, last, true);
 }
 
 /*!
@@ -173,18 +298,7 @@ int SelectableViewCollection::selectMany(const QSet<DataObject*>& select)
  */
 int SelectableViewCollection::unselectAll()
 {
-    if (m_selected.count() == 0)
-        return 0;
-
-    // save all that were selected to a list for the signal
-    QSet<DataObject*> unselected;
-    unselected.unite(m_selected);
-
-    m_selected.clear();
-
-    notifySelectionChanged(NULL, &unselected);
-
-    return unselected.count();
+    return unselectRange(0, count() - 1);
 }
 
 /*!
@@ -194,19 +308,18 @@ int SelectableViewCollection::unselectAll()
  */
 int SelectableViewCollection::unselectMany(const QSet<DataObject*>& unselect)
 {
-    QSet<DataObject*> unselected;
-    DataObject* object;
-    foreach (object, unselect) {
-        if (contains(object) && isSelected(object)) {
-            m_selected.remove(object);
-            unselected.insert(object);
-        }
-    }
-
-    if (unselected.count() > 0)
-        notifySelectionChanged(NULL, &unselected);
+    return setSelected(unselect, false);
+}
 
-    return unselected.count();
+/*!
+ * \brief SelectableViewCollection::unselectRange
+ * \param first
+ * \param last
+ * \return Returns the number of items unselected (that weren't unselected before)
+ */
+int SelectableViewCollection::unselectRange(int first, int last)
+{
+    return setRangeSelected(first, last, false);
 }
 
 /*!
@@ -267,3 +380,61 @@ void SelectableViewCollection::onMonitoringSelectionChanged(
     if (unselected != NULL)
         unselectMany(*unselected);
 }
+
+/*!
+ * \brief SelectableViewCollection::setSelected
+ * \param objects
+ * \param selected
+ * \return the number of objects whose selection state changed
+ */
+int SelectableViewCollection::setSelected(const QSet<DataObject*>& objects, bool selected)
+{
+    if (selected ? (m_selection.count() == count()) : (m_selection.count() == 0))
+        return 0;
+
+    QList<int> changed;
+    DataObject* object;
+    foreach (object, objects) {
+        int index = indexOf(object);
+        if (index >= 0 && m_selection.setBit(index, selected))
+            changed.append(index);
+    }
+
+    if (changed.isEmpty())
+        return 0;
+
+    qSort(changed);
+
+    QList<DataIndexRange> ranges;
+    foreach (int index, changed)
+        DataCollectionDelta::appendIndex(&ranges, index);
+
+    notifySelectionRangesChanged(&ranges, selected);
+
+    return changed.count();
+}
+
+/*!
+ * \brief SelectableViewCollection::setRangeSelected
+ * \param first
+ * \param last
+ * \param selected
+ * \return the number of objects whose selection state changed
+ */
+int SelectableViewCollection::setRangeSelected(int first, int last, bool selected)
+{
+    first = qMax(first, 0);
+    last = qMin(last, count() - 1);
+    if (first > last)
+        return 0;
+
+    // only the runs that actually change are reported
+    QList<DataIndexRange> ranges = m_selection.runs(first, last, !selected);
+    if (ranges.isEmpty())
+        return 0;
+
+    int changed = m_selection.setRange(first, last, selected);
+    notifySelectionRangesChanged(&ranges, selected);
+
+    return changed;
+}
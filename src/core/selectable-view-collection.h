@@ -23,27 +23,40 @@
 #include "data-object.h"
 #include "view-collection.h"
 
+// util
+#include "bit-set.h"
+
 #include <QSet>
 
 /**
   * SelectableViewCollection adds the notion of selection to a ViewCollection.
   * It's primarily of use in grid or checkerboard views when the user may want
   * to perform an operation on a number of DataSources all at once.
+  *
+  * Selection is held as a bit per index, kept aligned with the collection as
+  * it changes, so runs of DataObjects can be (un)selected and reported as
+  * index ranges without touching each object.
   */
 class SelectableViewCollection : public ViewCollection
 {
     Q_OBJECT
 
 signals:
+    // only built and fired if something is connected to it
     void selectionChanged(const QSet<DataObject*>* selected,
                           const QSet<DataObject*>* unselected);
 
+    // fired with the ascending index ranges whose selection state changed
+    void selectionRangesChanged(const QList<DataIndexRange>* ranges, bool selected);
+
 public:
     SelectableViewCollection(const QString& name);
 
     bool isSelected(DataObject* object) const;
+    bool isSelectedAt(int index) const;
 
     int selectedCount() const;
+    int selectedCount(int first, int last) const;
     const QSet<DataObject*>& getSelected() const;
 
     template <class T>
@@ -56,8 +69,10 @@ public:
     bool toggleSelect(DataObject* object);
     int selectAll();
     int selectMany(const QSet<DataObject*>& select);
+    int selectRange(int first, int last);
     int unselectAll();
     int unselectMany(const QSet<DataObject*>& unselect);
+    int unselectRange(int first, int last);
 
     // One SelectableViewCollection may monitor the selection status of another ...
     // this does *not* mirror the collection, merely alter selection state of
@@ -69,15 +84,27 @@ public:
 protected:
     virtual void notifyContentsToBeChanged(const QSet<DataObject*>* added,
                                                const QSet<DataObject*>* removed);
+    virtual void notifyContentsRangesChanged(const DataCollectionDelta* delta, bool notify);
+    virtual void notifyOrderingToBeChanged();
+    virtual void notifyOrderingChanged();
     virtual void notifySelectionChanged(QSet<DataObject*>* selected,
                                           QSet<DataObject*>* unselected);
+    virtual void notifySelectionRangesChanged(const QList<DataIndexRange>* ranges,
+                                              bool selected);
 
 private slots:
     void onMonitoringSelectionChanged(const QSet<DataObject*>* selected,
                                          const QSet<DataObject*>* unselected);
 
 private:
-    QSet<DataObject*> m_selected;
+    int setSelected(const QSet<DataObject*>& objects, bool selected);
+    int setRangeSelected(int first, int last, bool selected);
+
+    BitSet m_selection;
+    // getSelected() is built on demand from m_selection
+    mutable QSet<DataObject*> m_selected;
+    mutable bool m_selectedValid;
+    QSet<DataObject*> m_reordering;
     SelectableViewCollection* m_monitoringSelection;
 };
 
@@ -84,6 +84,57 @@ const DataCollection* ViewCollection::collection() const
     return m_monitoring;
 }
 
+/*!
+ * \brief ViewCollection::orderLike
+ * Takes the ordering of another collection holding all of this view's
+ * DataObjects, without re-sorting.  Passing the monitored collection resumes
+ * following its ordering; anything else stops following it.
+ * \param ordered
+ */
+void ViewCollection::orderLike(const DataCollection* ordered)
+{
+    bool follow = (m_monitoring != NULL && ordered == m_monitoring);
+
+    if (m_monitorOrdering && !follow) {
+        QObject::disconnect(m_monitoring, SIGNAL(orderingChanged()), this,
+                            SLOT(onMonitoredOrderingChanged()));
+    } else if (!m_monitorOrdering && follow) {
+        QObject::connect(m_monitoring, SIGNAL(orderingChanged()), this,
+                         SLOT(onMonitoredOrderingChanged()));
+    }
+
+    // cleared while reordering, as this is not the unstable case
+    // notifyOrderingChanged() warns about
+    m_monitorOrdering = false;
+    reorderLike(ordered);
+    m_monitorOrdering = follow;
+}
+
+/*!
+ * \brief ViewCollection::refilter
+ * Runs the monitored collection through the filter again after its criteria
+ * have changed, adding and removing only the DataObjects whose acceptance
+ * changed rather than rebuilding the view
+ */
+void ViewCollection::refilter()
+{
+    if (m_monitoring == NULL || m_monitorFilter == NULL)
+        return;
+
+    QSet<DataObject*> to_add;
+    QSet<DataObject*> to_remove;
+    foreach (DataObject* object, m_monitoring->getAll()) {
+        bool accepted = m_monitorFilter->isAccepted(object);
+        if (accepted && !contains(object))
+            to_add.insert(object);
+        else if (!accepted && contains(object))
+            to_remove.insert(object);
+    }
+
+    removeMany(to_remove, true);
+    addMany(to_add);
+}
+
 /*!
  * \brief ViewCollection::isMonitoring
  * \return
@@ -136,7 +187,13 @@ void ViewCollection::onMonitoredContentsChanged(const QSet<DataObject*>* added,
 
 void ViewCollection::onMonitoredContentDataChanged(DataObject* object)
 {
+    // the change may have moved the object within the ordering
+    refreshSortKey(object);
+
     if (m_monitorFilter == NULL) {
+        if (contains(object))
+            notifyContentDataChanged(object);
+
         return;
     }
 
@@ -145,7 +202,9 @@ void ViewCollection::onMonitoredContentDataChanged(DataObject* object)
             QSet<DataObject*> to_remove;
             to_remove.insert(object);
             removeMany(to_remove, true);
-        }   
+        } else {
+            notifyContentDataChanged(object);
+        }
     } else {
         if (m_monitorFilter->isAccepted(object)) {
             QSet<DataObject*> to_add;
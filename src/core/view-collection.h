@@ -62,6 +62,8 @@ public:
                                bool monitor_ordering);
     bool isMonitoring() const;
     const DataCollection* collection() const;
+    void orderLike(const DataCollection* ordered);
+    void refilter();
 
 signals:
     void collectionChanged();
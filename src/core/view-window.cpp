@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2014 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "view-window.h"
+
+/*!
+ * \brief uncoveredRanges
+ * \param first
+ * \param end
+ * \param spans ascending runs of indexes, first inclusive and second
+ * exclusive; empty spans are skipped
+ * \return the ascending ranges, first and last inclusive, between first and
+ * end that none of the spans cover
+ */
+static QList<DataIndexRange> uncoveredRanges(int first, int end,
+                                             const QList<DataIndexRange>& spans)
+{
+    QList<DataIndexRange> ranges;
+
+    int next = first;
+    foreach (const DataIndexRange& span, spans) {
+        if (span.first >= span.second)
+            continue;
+
+        if (span.first > next)
+            ranges.append(DataIndexRange(next, span.first - 1));
+
+        next = qMax(next, span.second);
+    }
+
+    if (end > next)
+        ranges.append(DataIndexRange(next, end - 1));
+
+    return ranges;
+}
+
+/*!
+ * \brief ViewWindow::end
+ * \param count
+ * \param head not negative
+ * \param limit
+ * \return the index one past the last of a head/limit window over count
+ * elements; the window is empty if this is no more than the head
+ */
+int ViewWindow::end(int count, int head, int limit)
+{
+    int end = (limit >= 0) ? qMin(count, head + limit) : count;
+
+    return qMax(end, head);
+}
+
+/*!
+ * \brief ViewWindow::moved
+ * The window moved or was resized over the same elements
+ * \param count
+ * \param oldHead
+ * \param oldLimit
+ * \param head
+ * \param limit
+ * \return
+ */
+ViewWindowChange ViewWindow::moved(int count, int oldHead, int oldLimit, int head, int limit)
+{
+    int old_end = end(count, oldHead, oldLimit);
+    int new_end = end(count, head, limit);
+
+    QList<DataIndexRange> kept;
+    kept.append(DataIndexRange(qMax(oldHead, head), qMin(old_end, new_end)));
+
+    return shifted(oldHead, old_end, head, new_end, kept, kept);
+}
+
+/*!
+ * \brief ViewWindow::rangeRemoved
+ * Elements before the removed range stay put and those after it move down,
+ * so rows can slide out of the front of the window and others slide in at
+ * its end
+ * \param count the number of elements before the removal
+ * \param head
+ * \param limit
+ * \param first
+ * \param last
+ * \return
+ */
+ViewWindowChange ViewWindow::rangeRemoved(int count, int head, int limit, int first, int last)
+{
+    int removed = last - first + 1;
+    int old_end = end(count, head, limit);
+    int new_end = end(count - removed, head, limit);
+
+    // the elements in the window both before and after, as they were indexed
+    // before the removal and after it
+    QList<DataIndexRange> old_kept;
+    QList<DataIndexRange> new_kept;
+
+    int before_end = qMin(qMin(old_end, new_end), first);
+    old_kept.append(DataIndexRange(head, before_end));
+    new_kept.append(DataIndexRange(head, before_end));
+
+    int after_first = qMax(head + removed, last + 1);
+    int after_end = qMin(new_end + removed, old_end);
+    old_kept.append(DataIndexRange(after_first, after_end));
+    new_kept.append(DataIndexRange(after_first - removed, after_end - removed));
+
+    return shifted(head, old_end, head, new_end, old_kept, new_kept);
+}
+
+/*!
+ * \brief ViewWindow::rangeInserted
+ * Elements from the inserted range on move up, so rows can slide out of the
+ * end of the window and the inserted elements (or ones before them) join it
+ * \param count the number of elements before the insertion
+ * \param head
+ * \param limit
+ * \param first
+ * \param last
+ * \return
+ */
+ViewWindowChange ViewWindow::rangeInserted(int count, int head, int limit, int first, int last)
+{
+    int inserted = last - first + 1;
+    int old_end = end(count, head, limit);
+    int new_end = end(count + inserted, head, limit);
+
+    QList<DataIndexRange> old_kept;
+    QList<DataIndexRange> new_kept;
+
+    int before_end = qMin(qMin(old_end, new_end), first);
+    old_kept.append(DataIndexRange(head, before_end));
+    new_kept.append(DataIndexRange(head, before_end));
+
+    int after_first = qMax(head, first);
+    int after_end = qMin(old_end, new_end - inserted);
+    old_kept.append(DataIndexRange(after_first, after_end));
+    new_kept.append(DataIndexRange(after_first + inserted, after_end + inserted));
+
+    return shifted(head, old_end, head, new_end, old_kept, new_kept);
+}
+
+/*!
+ * \brief ViewWindow::shifted
+ * The rows of the old window that weren't kept are removed, then the rows of
+ * the new window that weren't kept are added
+ * \param oldFirst
+ * \param oldEnd
+ * \param newFirst
+ * \param newEnd
+ * \param oldKept the elements in both windows, as indexed before the change
+ * \param newKept the same elements as indexed after the change
+ * \return
+ */
+ViewWindowChange ViewWindow::shifted(int oldFirst, int oldEnd, int newFirst, int newEnd,
+                                     const QList<DataIndexRange>& oldKept,
+                                     const QList<DataIndexRange>& newKept)
+{
+    ViewWindowChange change;
+
+    QList<DataIndexRange> removed = uncoveredRanges(oldFirst, oldEnd, oldKept);
+    for (int i = removed.count() - 1; i >= 0; --i) {
+        change.removedRows.append(DataIndexRange(removed[i].first - oldFirst,
+                                                 removed[i].second - oldFirst));
+    }
+
+    foreach (const DataIndexRange& range, uncoveredRanges(newFirst, newEnd, newKept)) {
+        change.addedRows.append(DataIndexRange(range.first - newFirst,
+                                               range.second - newFirst));
+    }
+
+    return change;
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2014 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GALLERY_VIEW_WINDOW_H_
+#define GALLERY_VIEW_WINDOW_H_
+
+// core
+#include "data-collection.h"
+
+#include <QList>
+
+/**
+  * The rows a head/limit window over a collection loses and gains when the
+  * collection changes or the window is moved.  Rows are counted from the
+  * window's head.  The removed rows are in descending order, so each run is
+  * still accurate when reached if they are reported in turn; the added rows
+  * are in ascending order, as rows of the changed window.
+  */
+struct ViewWindowChange
+{
+    QList<DataIndexRange> removedRows;
+    QList<DataIndexRange> addedRows;
+};
+
+/**
+  * Works out which rows of a window, starting at a (non-negative) head and
+  * holding up to limit elements (or all of them if the limit is negative),
+  * change when elements are removed or inserted, or the window moves.  Rows
+  * of elements that stay in the window are never reported, so their
+  * delegates can be kept.
+  */
+class ViewWindow
+{
+public:
+    static int end(int count, int head, int limit);
+
+    static ViewWindowChange moved(int count, int oldHead, int oldLimit, int head, int limit);
+    static ViewWindowChange rangeRemoved(int count, int head, int limit, int first, int last);
+    static ViewWindowChange rangeInserted(int count, int head, int limit, int first, int last);
+
+private:
+    static ViewWindowChange shifted(int oldFirst, int oldEnd, int newFirst, int newEnd,
+                                    const QList<DataIndexRange>& oldKept,
+                                    const QList<DataIndexRange>& newKept);
+};
+
+#endif  // GALLERY_VIEW_WINDOW_H_
@@ -38,11 +38,22 @@ AlbumTable::AlbumTable(Database* db, QObject* parent)
 
 /*!
  * \brief AlbumTable::get_albums returns a set of all albums
- * Returns a set of all getAlbums
+ * Returns a set of all getAlbums.  The albums' media aren't linked up; only
+ * their ids are read, all in one query, for the albums to load from later.
  * \param albumSet
+ * \param albumMedia the ids of the media in each album, by album id
  */
-void AlbumTable::getAlbums(QList<Album*>* albumSet)
+void AlbumTable::getAlbums(QList<Album*>* albumSet,
+                           QHash<qint64, QList<qint64> >* albumMedia)
 {
+    QSqlQuery media_query(*m_db->getDB());
+    media_query.prepare("SELECT album_id, media_id FROM MediaAlbumTable");
+    if (!media_query.exec())
+        m_db->logSqlError(media_query);
+
+    while (media_query.next())
+        (*albumMedia)[media_query.value(0).toLongLong()].append(media_query.value(1).toLongLong());
+
     QSqlQuery query(*m_db->getDB());
     query.prepare("SELECT id, title, subtitle, time_added, is_closed, current_page, "
                   "cover_nickname FROM AlbumTable ORDER BY time_added DESC");
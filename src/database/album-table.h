@@ -20,6 +20,7 @@
 #ifndef ALBUMTABLE_H
 #define ALBUMTABLE_H
 
+#include <QHash>
 #include <QList>
 #include <QObject>
 
@@ -36,7 +37,7 @@ class AlbumTable : public QObject
 public:
     explicit AlbumTable(Database* db, QObject* parent = 0);
 
-    void getAlbums(QList<Album*>* albumSet);
+    void getAlbums(QList<Album*>* albumSet, QHash<qint64, QList<qint64> >* albumMedia);
 
     void addAlbum(Album* album);
     void removeAlbum(Album* album);
@@ -52,14 +52,7 @@ Event* EventCollection::eventForDate(const QDate& date) const
  */
 Event* EventCollection::eventForMediaSource(MediaSource* media) const
 {
-    // TODO: Could use lookup table here, but this is fine for now
-    Event* event;
-    foreach (event, getAllAsType<Event*>()) {
-        if (event->contains(media))
-            return event;
-    }
-
-    return NULL;
+    return m_mediaMap.value(media);
 }
 
 /*!
@@ -107,6 +100,7 @@ void EventCollection::onMediaAddedRemoved(const QSet<DataObject *> *added,
 
             modifiedEvent = existing;
 
+            m_mediaMap.insert(media, existing);
             toAddHash[existing].insert(object);
         }
 
@@ -118,15 +112,27 @@ void EventCollection::onMediaAddedRemoved(const QSet<DataObject *> *added,
     }
 
     if (removed != NULL) {
+        // Look the Events up by media rather than by date, in case the
+        // exposure date has changed since the media was added, and detach
+        // from each Event once
+        QHash<Event*, QSet<DataObject*>> toRemoveHash;
+
         DataObject* object;
         foreach (object, *removed) {
             MediaSource* media = qobject_cast<MediaSource*>(object);
             Q_ASSERT(media != NULL);
 
-            Event* event = m_dateMap.value(media->exposureDate());
+            Event* event = m_mediaMap.take(media);
             Q_ASSERT(event != NULL);
 
-            event->detach(media, false);
+            toRemoveHash[event].insert(object);
+        }
+
+        QHashIterator<Event*, QSet<DataObject*>> i(toRemoveHash);
+        while (i.hasNext()) {
+            i.next();
+            Event* event = i.key();
+            event->detachMany(i.value(), false);
 
             if (event->containedCount() == 0) {
                 destroy(event, true, true);
@@ -57,6 +57,7 @@ private:
     static bool comparator(DataObject* a, DataObject* b);
 
     QHash<QDate, Event*> m_dateMap;
+    QHash<MediaSource*, Event*> m_mediaMap;
 };
 
 #endif  // GALLERY_EVENT_COLLECTION_H_
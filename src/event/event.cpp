@@ -24,12 +24,16 @@
 
 #include <QString>
 
+#include <limits>
+
 /*!
  * \brief Event::Event
  * \param parent
  */
 Event::Event(QObject* parent)
-    : ContainerSource(parent, "Event (undated)", MediaCollection::exposureDateTimeDescendingComparator)
+    : ContainerSource(parent, "Event (undated)", MediaCollection::exposureDateTimeDescendingComparator),
+      m_startMSecs(std::numeric_limits<qint64>::min()),
+      m_endMSecs(std::numeric_limits<qint64>::min())
 {
 }
 
@@ -40,8 +44,14 @@ Event::Event(QObject* parent)
  */
 Event::Event(QObject* parent, const QDate& date)
     : ContainerSource(parent, QString("Event for ") + date.toString(),
-                      MediaCollection::exposureDateTimeDescendingComparator), m_date(date)
+                      MediaCollection::exposureDateTimeDescendingComparator), m_date(date),
+      m_startMSecs(std::numeric_limits<qint64>::min()),
+      m_endMSecs(std::numeric_limits<qint64>::min())
 {
+    if (m_date.isValid()) {
+        m_startMSecs = startDateTime().toMSecsSinceEpoch();
+        m_endMSecs = endDateTime().toMSecsSinceEpoch();
+    }
 }
 
 /*!
@@ -71,6 +81,24 @@ QDateTime Event::endDateTime() const
     return QDateTime(date(), QTime(23, 59, 59, 999));
 }
 
+/*!
+ * \brief Event::startMSecs
+ * \return startDateTime() as milliseconds since the epoch
+ */
+qint64 Event::startMSecs() const
+{
+    return m_startMSecs;
+}
+
+/*!
+ * \brief Event::endMSecs
+ * \return endDateTime() as milliseconds since the epoch
+ */
+qint64 Event::endMSecs() const
+{
+    return m_endMSecs;
+}
+
 /*!
  * \brief Event::DestroySource \reimp
  * \param destroyBacking
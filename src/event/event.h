@@ -50,12 +50,16 @@ public:
     const QDate& date() const;
     QDateTime startDateTime() const;
     QDateTime endDateTime() const;
+    qint64 startMSecs() const;
+    qint64 endMSecs() const;
 
 protected:
     virtual void destroySource(bool destroyBacking, bool asOrphan);
 
 private:
     QDate m_date;
+    qint64 m_startMSecs;
+    qint64 m_endMSecs;
 };
 
 QML_DECLARE_TYPE(Event)
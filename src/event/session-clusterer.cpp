@@ -0,0 +1,360 @@
+/*
+ * Copyright (C) 2014 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "session-clusterer.h"
+
+// media
+#include "media-source.h"
+
+/*!
+ * \brief SessionClusterer::SessionClusterer
+ * \param gapMSecs the longest time between two media of the same session
+ */
+SessionClusterer::SessionClusterer(qint64 gapMSecs)
+    : m_gap(gapMSecs)
+{
+    Q_ASSERT(gapMSecs >= 0);
+}
+
+/*!
+ * \brief SessionClusterer::gap
+ * \return
+ */
+qint64 SessionClusterer::gap() const
+{
+    return m_gap;
+}
+
+/*!
+ * \brief SessionClusterer::setGap
+ * Sessions are worked out again in one pass over the sorted media, and
+ * pending changes are dropped, as every session may have changed
+ * \param gapMSecs
+ */
+void SessionClusterer::setGap(qint64 gapMSecs)
+{
+    Q_ASSERT(gapMSecs >= 0);
+    if (gapMSecs == m_gap)
+        return;
+
+    m_gap = gapMSecs;
+    m_spans.clear();
+    m_before.clear();
+
+    Spans::iterator current = m_spans.end();
+    QMap<Key, MediaSource*>::const_iterator i;
+    for (i = m_media.constBegin(); i != m_media.constEnd(); ++i) {
+        if (current != m_spans.end() && withinGap(current->last.first, i.key().first, m_gap)) {
+            current->last = i.key();
+            current->count++;
+        } else {
+            Span span = { i.key(), 1 };
+            current = m_spans.insert(i.key(), span);
+        }
+    }
+}
+
+/*!
+ * \brief SessionClusterer::mediaCount
+ * \return
+ */
+int SessionClusterer::mediaCount() const
+{
+    return m_media.count();
+}
+
+/*!
+ * \brief SessionClusterer::sessionCount
+ * \return
+ */
+int SessionClusterer::sessionCount() const
+{
+    return m_spans.count();
+}
+
+/*!
+ * \brief SessionClusterer::sessions
+ * \return the sessions from the oldest to the newest
+ */
+QList<SessionClusterer::Session> SessionClusterer::sessions() const
+{
+    QList<Session> sessions;
+    sessions.reserve(m_spans.count());
+
+    Spans::const_iterator i;
+    for (i = m_spans.constBegin(); i != m_spans.constEnd(); ++i)
+        sessions.append(toSession(i.key(), *i));
+
+    return sessions;
+}
+
+/*!
+ * \brief SessionClusterer::takeChanges
+ * A session that was changed and then put back as it was is not reported
+ * \return the sessions removed, changed or added since the last call
+ */
+SessionClusterer::Changes SessionClusterer::takeChanges()
+{
+    Changes changes;
+
+    Spans::const_iterator i;
+    for (i = m_before.constBegin(); i != m_before.constEnd(); ++i) {
+        Spans::const_iterator now = m_spans.constFind(i.key());
+        bool was = (i->count > 0);
+        bool is = (now != m_spans.constEnd());
+
+        if (was && !is)
+            changes.removed.append(toSession(i.key(), *i));
+        else if (!was && is)
+            changes.added.append(toSession(i.key(), *now));
+        else if (was && is && (now->last != i->last || now->count != i->count))
+            changes.changed.append(toSession(i.key(), *now));
+    }
+
+    m_before.clear();
+
+    return changes;
+}
+
+/*!
+ * \brief SessionClusterer::insert
+ * \param media
+ * \return false if the media was already there
+ */
+bool SessionClusterer::insert(MediaSource* media)
+{
+    if (m_keys.contains(media))
+        return false;
+
+    Key key(media->exposureMSecs(), media->number());
+    m_keys.insert(media, key);
+    insertKey(key, media);
+
+    return true;
+}
+
+/*!
+ * \brief SessionClusterer::remove
+ * \param media
+ * \return false if the media wasn't there
+ */
+bool SessionClusterer::remove(MediaSource* media)
+{
+    if (!m_keys.contains(media))
+        return false;
+
+    removeKey(m_keys.take(media));
+
+    return true;
+}
+
+/*!
+ * \brief SessionClusterer::update
+ * Moves the media if its exposure time has changed since it was inserted
+ * \param media
+ * \return true if the media was moved
+ */
+bool SessionClusterer::update(MediaSource* media)
+{
+    QHash<MediaSource*, Key>::iterator found = m_keys.find(media);
+    if (found == m_keys.end() || found->first == media->exposureMSecs())
+        return false;
+
+    removeKey(*found);
+    *found = Key(media->exposureMSecs(), media->number());
+    insertKey(*found, media);
+
+    return true;
+}
+
+/*!
+ * \brief SessionClusterer::clear
+ */
+void SessionClusterer::clear()
+{
+    m_media.clear();
+    m_keys.clear();
+    m_spans.clear();
+    m_before.clear();
+}
+
+/*!
+ * \brief SessionClusterer::withinGap
+ * Works in unsigned arithmetic, as an unset exposure time is the lowest
+ * qint64 and subtracting it would overflow
+ * \param fromMSecs
+ * \param toMSecs no earlier than fromMSecs
+ * \param gapMSecs
+ * \return true if the two times are no more than the gap apart
+ */
+bool SessionClusterer::withinGap(qint64 fromMSecs, qint64 toMSecs, qint64 gapMSecs)
+{
+    Q_ASSERT(fromMSecs <= toMSecs);
+
+    return static_cast<quint64>(toMSecs) - static_cast<quint64>(fromMSecs)
+            <= static_cast<quint64>(gapMSecs);
+}
+
+/*!
+ * \brief SessionClusterer::toSession
+ * \param first
+ * \param span
+ * \return
+ */
+SessionClusterer::Session SessionClusterer::toSession(const Key& first, const Span& span)
+{
+    Session session = { first.first, span.last.first, span.count, first.second };
+
+    return session;
+}
+
+/*!
+ * \brief SessionClusterer::insertKey
+ * The new media can only join the sessions of its neighbours, possibly
+ * bridging the two
+ * \param key
+ * \param media
+ */
+void SessionClusterer::insertKey(const Key& key, MediaSource* media)
+{
+    QMap<Key, MediaSource*>::iterator at = m_media.insert(key, media);
+
+    QMap<Key, MediaSource*>::iterator previous = at;
+    bool joins_previous = (at != m_media.begin())
+            && withinGap((--previous).key().first, key.first, m_gap);
+
+    QMap<Key, MediaSource*>::iterator next = at;
+    bool joins_next = (++next != m_media.end()) && withinGap(key.first, next.key().first, m_gap);
+
+    if (joins_previous) {
+        Spans::iterator span = spanOf(previous.key());
+        touch(span.key());
+        span->count++;
+
+        // if the previous media ended its session the next one, if any,
+        // started another
+        if (span->last == previous.key()) {
+            if (joins_next) {
+                Spans::iterator following = m_spans.find(next.key());
+                Q_ASSERT(following != m_spans.end());
+                touch(following.key());
+
+                span->last = following->last;
+                span->count += following->count;
+                m_spans.erase(following);
+            } else {
+                span->last = key;
+            }
+        }
+    } else if (joins_next) {
+        // too far from the previous media, so the next one started a session
+        Spans::iterator following = m_spans.find(next.key());
+        Q_ASSERT(following != m_spans.end());
+        touch(following.key());
+        touch(key);
+
+        Span span = *following;
+        span.count++;
+        m_spans.erase(following);
+        m_spans.insert(key, span);
+    } else {
+        touch(key);
+
+        Span span = { key, 1 };
+        m_spans.insert(key, span);
+    }
+}
+
+/*!
+ * \brief SessionClusterer::removeKey
+ * \param key
+ */
+void SessionClusterer::removeKey(const Key& key)
+{
+    QMap<Key, MediaSource*>::iterator at = m_media.find(key);
+    Q_ASSERT(at != m_media.end());
+
+    Spans::iterator span = spanOf(key);
+    touch(span.key());
+    span->count--;
+
+    if (span.key() == key && span->last == key) {
+        m_spans.erase(span);
+    } else if (span.key() == key) {
+        QMap<Key, MediaSource*>::iterator next = at;
+        ++next;
+        touch(next.key());
+
+        Span rest = *span;
+        m_spans.erase(span);
+        m_spans.insert(next.key(), rest);
+    } else if (span->last == key) {
+        QMap<Key, MediaSource*>::iterator previous = at;
+        --previous;
+
+        span->last = previous.key();
+    } else {
+        QMap<Key, MediaSource*>::iterator previous = at;
+        --previous;
+        QMap<Key, MediaSource*>::iterator next = at;
+        ++next;
+
+        // the gap left behind splits the session in two
+        if (!withinGap(previous.key().first, next.key().first, m_gap)) {
+            int count = 0;
+            for (QMap<Key, MediaSource*>::iterator i = m_media.find(span.key()); i != at; ++i)
+                count++;
+
+            touch(next.key());
+
+            Span tail = { span->last, span->count - count };
+            span->last = previous.key();
+            span->count = count;
+            m_spans.insert(next.key(), tail);
+        }
+    }
+
+    m_media.erase(at);
+}
+
+/*!
+ * \brief SessionClusterer::spanOf
+ * \param key a media that is present
+ * \return the session holding the media
+ */
+SessionClusterer::Spans::iterator SessionClusterer::spanOf(const Key& key)
+{
+    Spans::iterator span = m_spans.upperBound(key);
+    Q_ASSERT(span != m_spans.begin());
+
+    return --span;
+}
+
+/*!
+ * \brief SessionClusterer::touch
+ * Keeps the session starting at a media as it was before its first change
+ * since the last takeChanges()
+ * \param first
+ */
+void SessionClusterer::touch(const Key& first)
+{
+    if (m_before.contains(first))
+        return;
+
+    Spans::const_iterator span = m_spans.constFind(first);
+    Span none = { first, 0 };
+    m_before.insert(first, (span != m_spans.constEnd()) ? *span : none);
+}
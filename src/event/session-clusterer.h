@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2014 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GALLERY_SESSION_CLUSTERER_H_
+#define GALLERY_SESSION_CLUSTERER_H_
+
+// core
+#include "data-object.h"
+
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QPair>
+
+class MediaSource;
+
+/**
+  * Groups media into sessions: runs of media, in exposure time order, where
+  * no two neighbours are more than a gap apart.  Unlike Events a session can
+  * run over midnight, and a day with long breaks falls into several sessions.
+  *
+  * Media are held sorted by exposure time, and each session by its first and
+  * last media, so adding or removing a media only looks at its neighbours and
+  * takes O(log n).  The only exception is removing a media that splits its
+  * session in two, which walks the first half to count it.
+  *
+  * The sessions touched since the last call to takeChanges() are kept, so a
+  * view can update just those rows.
+  */
+class SessionClusterer
+{
+public:
+    struct Session {
+        qint64 startMSecs;
+        qint64 endMSecs;
+        int count;
+        // the first media's number, telling sessions with the same start apart
+        DataObjectNumber startNumber;
+    };
+
+    // a session keeps its start while only its end and count change
+    struct Changes {
+        QList<Session> removed;
+        QList<Session> changed;
+        QList<Session> added;
+    };
+
+    SessionClusterer(qint64 gapMSecs);
+
+    qint64 gap() const;
+    void setGap(qint64 gapMSecs);
+
+    int mediaCount() const;
+    int sessionCount() const;
+    QList<Session> sessions() const;
+    Changes takeChanges();
+
+    bool insert(MediaSource* media);
+    bool remove(MediaSource* media);
+    bool update(MediaSource* media);
+    void clear();
+
+private:
+    // exposure time, with the DataObjectNumber to tell equal times apart
+    typedef QPair<qint64, DataObjectNumber> Key;
+
+    struct Span {
+        Key last;
+        int count;
+    };
+
+    typedef QMap<Key, Span> Spans;
+
+    static bool withinGap(qint64 fromMSecs, qint64 toMSecs, qint64 gapMSecs);
+    static Session toSession(const Key& first, const Span& span);
+
+    void insertKey(const Key& key, MediaSource* media);
+    void removeKey(const Key& key);
+    Spans::iterator spanOf(const Key& key);
+    void touch(const Key& first);
+
+    qint64 m_gap;
+    QMap<Key, MediaSource*> m_media;
+    QHash<MediaSource*, Key> m_keys;
+    // keyed by each session's first media
+    Spans m_spans;
+    // the touched sessions as they were at the last takeChanges(), with a
+    // count of 0 where none started
+    Spans m_before;
+};
+
+#endif  // GALLERY_SESSION_CLUSTERER_H_
@@ -43,6 +43,7 @@
 #include "qml-event-collection-model.h"
 #include "qml-event-overview-model.h"
 #include "qml-media-collection-model.h"
+#include "qml-session-collection-model.h"
 
 // util
 #include "command-line-parser.h"
@@ -162,6 +163,7 @@ void GalleryApplication::registerQML()
     qmlRegisterType<QmlEventCollectionModel>("Gallery", 1, 0, "EventCollectionModel");
     qmlRegisterType<QmlEventOverviewModel>("Gallery", 1, 0, "EventOverviewModel");
     qmlRegisterType<QmlMediaCollectionModel>("Gallery", 1, 0, "MediaCollectionModel");
+    qmlRegisterType<QmlSessionCollectionModel>("Gallery", 1, 0, "SessionCollectionModel");
 
     qRegisterMetaType<QList<MediaSource*> >("MediaSourceList");
     qRegisterMetaType<QSet<DataObject*> >("QSet<DataObject*>");
@@ -122,6 +122,18 @@ void GalleryManager::enableContentLoadFilter(MediaSource::MediaType filterType)
     m_mediaFactory->enableContentLoadFilter(filterType);
 }
 
+/*!
+ * \brief GalleryManager::setMediaViewport lets the media factory load the
+ * files around the media shown on screen first
+ * \param firstMSecs
+ * \param lastMSecs
+ */
+void GalleryManager::setMediaViewport(qint64 firstMSecs, qint64 lastMSecs)
+{
+    if (m_mediaFactory != NULL)
+        m_mediaFactory->setViewport(firstMSecs, lastMSecs);
+}
+
 /*!
  * \brief GalleryManager::postInit
  * Called after main loop is initialised. See GalleryApplication::exec() comments.
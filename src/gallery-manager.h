@@ -57,6 +57,7 @@ public:
     static GalleryManager* instance();
 
     void enableContentLoadFilter(MediaSource::MediaType filterType);
+    void setMediaViewport(qint64 firstMSecs, qint64 lastMSecs);
     void postInit();
 
     Database *database() { return m_database; }
@@ -32,9 +32,33 @@
 
 #include <QApplication>
 
+#include <algorithm>
+#include <limits>
+
 QWaitCondition listNotEmptyCondition;
 QMutex createMutex;
-QStringList createQueue;
+QList<MediaCreateRequest> createQueue;
+qint64 createSequence = 0;
+qint64 viewportFirstMSecs = std::numeric_limits<qint64>::max();
+qint64 viewportLastMSecs = std::numeric_limits<qint64>::min();
+bool viewportChanged = false;
+
+/*!
+ * \brief laterThan orders the pending requests as a heap, the most urgent
+ * first: higher priority, then closer to the viewport, then first come
+ * \param a
+ * \param b
+ * \return true if a should be loaded after b
+ */
+static bool laterThan(const MediaCreateRequest& a, const MediaCreateRequest& b)
+{
+    if (a.priority != b.priority)
+        return a.priority < b.priority;
+    if (a.distance != b.distance)
+        return a.distance > b.distance;
+
+    return a.sequence > b.sequence;
+}
 
 /*!
  * \brief MediaObjectFactory::MediaObjectFactory
@@ -117,19 +141,48 @@ void MediaObjectFactory::loadMediaFromDB()
     QMetaObject::invokeMethod(m_worker, "mediaFromDB", Qt::QueuedConnection);
 }
 
+/*!
+ * \brief MediaObjectFactory::setViewport tells the factory which part of the
+ * timeline is on screen, so that the files pending there get loaded first.
+ * Files far from it are not dropped, only loaded later.
+ * \param firstMSecs the oldest exposure time in view
+ * \param lastMSecs the newest exposure time in view
+ */
+void MediaObjectFactory::setViewport(qint64 firstMSecs, qint64 lastMSecs)
+{
+    createMutex.lock();
+    if (firstMSecs != viewportFirstMSecs || lastMSecs != viewportLastMSecs) {
+        viewportFirstMSecs = firstMSecs;
+        viewportLastMSecs = lastMSecs;
+        viewportChanged = true;
+    }
+    createMutex.unlock();
+}
+
+/*!
+ * \brief MediaObjectFactory::enqueuePath hands a file over to the worker
+ * \param path
+ * \param priority
+ */
 void MediaObjectFactory::enqueuePath(const QString &path, int priority)
 {
+    MediaCreateRequest request;
+    request.path = path;
+    request.priority = priority;
+    request.timestamp = -1;
+    request.distance = 0;
+
     createMutex.lock();
-    if (priority == Qt::HighEventPriority)
-        createQueue.prepend(path);
-    else
-        createQueue.append(path);
+    request.sequence = createSequence++;
+    createQueue.append(request);
     createMutex.unlock();
     listNotEmptyCondition.wakeAll();
 }
 
 MediaObjectFactoryWorker::MediaObjectFactoryWorker(QObject *parent)
     : QObject(parent),
+      m_viewportFirstMSecs(std::numeric_limits<qint64>::max()),
+      m_viewportLastMSecs(std::numeric_limits<qint64>::min()),
       m_mediaTable(),
       m_filterType(MediaSource::None)
 {
@@ -139,18 +192,44 @@ MediaObjectFactoryWorker::~MediaObjectFactoryWorker()
 {
 }
 
+/*!
+ * \brief MediaObjectFactoryWorker::runCreate loads the queued files, keeping
+ * the ones pending as a heap so the most urgent is always taken next. When
+ * the viewport moves the heap is rebuilt once, instead of on every file.
+ */
 void MediaObjectFactoryWorker::runCreate()
 {
     forever {
-        QString path;
+        QList<MediaCreateRequest> arrived;
+        bool reorder;
         createMutex.lock();
-        if (createQueue.isEmpty()) {
+        while (createQueue.isEmpty() && m_pending.isEmpty()) {
             listNotEmptyCondition.wait(&createMutex);
         }
 
-        path = createQueue.takeFirst();
+        arrived.swap(createQueue);
+        reorder = viewportChanged;
+        viewportChanged = false;
+        m_viewportFirstMSecs = viewportFirstMSecs;
+        m_viewportLastMSecs = viewportLastMSecs;
         createMutex.unlock();
 
+        if (reorder) {
+            for (int i = 0; i < m_pending.count(); ++i)
+                measureDistance(&m_pending[i]);
+            std::make_heap(m_pending.begin(), m_pending.end(), laterThan);
+        }
+
+        foreach (MediaCreateRequest request, arrived) {
+            measureDistance(&request);
+            m_pending.append(request);
+            std::push_heap(m_pending.begin(), m_pending.end(), laterThan);
+        }
+
+        std::pop_heap(m_pending.begin(), m_pending.end(), laterThan);
+        QString path = m_pending.last().path;
+        m_pending.removeLast();
+
         QFileInfo file(path);
         if(file.exists()) {
             create(path);
@@ -158,6 +237,30 @@ void MediaObjectFactoryWorker::runCreate()
     }
 }
 
+/*!
+ * \brief MediaObjectFactoryWorker::measureDistance sets how far the request's
+ * file is from the viewport, using its modification time as an estimate of
+ * its exposure time. The file is only looked at once there is a viewport.
+ * \param request
+ */
+void MediaObjectFactoryWorker::measureDistance(MediaCreateRequest *request) const
+{
+    if (m_viewportFirstMSecs > m_viewportLastMSecs) {
+        request->distance = 0;
+        return;
+    }
+
+    if (request->timestamp < 0)
+        request->timestamp = QFileInfo(request->path).lastModified().toMSecsSinceEpoch();
+
+    if (request->timestamp < m_viewportFirstMSecs)
+        request->distance = m_viewportFirstMSecs - request->timestamp;
+    else if (request->timestamp > m_viewportLastMSecs)
+        request->distance = request->timestamp - m_viewportLastMSecs;
+    else
+        request->distance = 0;
+}
+
 void MediaObjectFactoryWorker::setMediaTable(MediaTable *mediaTable)
 {
     m_mediaTable = mediaTable;
@@ -231,6 +334,7 @@ void MediaObjectFactoryWorker::create(const QString &path)
     }
     media->setSize(m_size);
     media->setFileTimestamp(m_timeStamp);
+    media->setFileSize(m_fileSize > 0 ? m_fileSize : file.size());
     media->setExposureDateTime(m_exposureTime);
     if (mediaType == MediaSource::Photo) {
         photo->setOriginalOrientation(m_orientation);
@@ -357,8 +461,6 @@ void MediaObjectFactoryWorker::addMedia(qint64 mediaId, const QString &filename,
                                   const QDateTime &exposureTime,
                                   Orientation originalOrientation, qint64 filesize)
 {
-    Q_UNUSED(filesize);
-
     QFileInfo file(filename);
     if (!file.exists()) {
         m_mediaTable->remove(mediaId);
@@ -381,6 +483,7 @@ void MediaObjectFactoryWorker::addMedia(qint64 mediaId, const QString &filename,
 
     media->setSize(size);
     media->setFileTimestamp(timestamp);
+    media->setFileSize(filesize);
     media->setExposureDateTime(exposureTime);
     if (mediaType == MediaSource::Photo) {
         photo->setOriginalOrientation(originalOrientation);
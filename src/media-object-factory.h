@@ -29,6 +29,7 @@
 #include <QObject>
 #include <QSize>
 #include <QThread>
+#include <QVector>
 
 class MediaTable;
 class MediaObjectFactoryWorker;
@@ -49,6 +50,7 @@ public:
     void clear();
     void create(const QFileInfo& file, int priority, bool desktopMode, Resource *res);
     void loadMediaFromDB();
+    void setViewport(qint64 firstMSecs, qint64 lastMSecs);
 
 signals:
     void mediaObjectCreated(MediaSource *newMediaObject);
@@ -62,6 +64,19 @@ private:
     bool m_isRunCreateRunning;
 };
 
+/*!
+ * \brief The MediaCreateRequest struct is a file waiting to be loaded by the
+ * MediaObjectFactoryWorker
+ */
+struct MediaCreateRequest
+{
+    QString path;
+    int priority;
+    qint64 sequence;
+    qint64 timestamp;
+    qint64 distance;
+};
+
 /*!
  * \brief The MediaObjectFactoryWorker class does the actual object factory, but is
  * supposed to do it in a thread
@@ -95,6 +110,11 @@ private:
     void clearMetadata();
     bool readPhotoMetadata(const QFileInfo &file);
     bool readVideoMetadata(const QFileInfo &file);
+    void measureDistance(MediaCreateRequest *request) const;
+
+    QVector<MediaCreateRequest> m_pending;
+    qint64 m_viewportFirstMSecs;
+    qint64 m_viewportLastMSecs;
 
     MediaTable *m_mediaTable;
     MediaSource::MediaType m_filterType;
@@ -20,6 +20,9 @@
 #include "media-collection.h"
 #include "media-source.h"
 
+// core
+#include "view-collection.h"
+
 // database
 #include "database.h"
 #include "media-table.h"
@@ -36,10 +39,24 @@ MediaCollection::MediaCollection(MediaTable *mediaTable)
     : SourceCollection("MediaCollection"),
       m_mediaTable(mediaTable)
 {
+    registerSortKey(exposureDateTimeAscendingComparator, exposureDateTimeAscendingKey);
+    registerSortKey(exposureDateTimeDescendingComparator, exposureDateTimeDescendingKey);
+    registerSortKey(fileTimestampDescendingComparator, fileTimestampDescendingKey);
+    registerSortKey(fileSizeDescendingComparator, fileSizeDescendingKey);
+    registerSortKey(pixelCountDescendingComparator, pixelCountDescendingKey);
+
     // By default, sort all media by its exposure date time, descending
     setComparator(exposureDateTimeDescendingComparator);
 }
 
+/*!
+ * \brief MediaCollection::~MediaCollection
+ */
+MediaCollection::~MediaCollection()
+{
+    qDeleteAll(m_sortIndexes);
+}
+
 /*!
  * \brief MediaCollection::exposureDateTimeAscendingComparator
  * NOTE: this comparator function expects the API contract of
@@ -53,8 +70,8 @@ MediaCollection::MediaCollection(MediaTable *mediaTable)
 bool MediaCollection::exposureDateTimeAscendingComparator(DataObject* a,
                                                           DataObject* b)
 {
-    const QDateTime &exptime_a = qobject_cast<MediaSource*>(a)->exposureDateTime();
-    const QDateTime &exptime_b = qobject_cast<MediaSource*>(b)->exposureDateTime();
+    qint64 exptime_a = static_cast<MediaSource*>(a)->exposureMSecs();
+    qint64 exptime_b = static_cast<MediaSource*>(b)->exposureMSecs();
 
     return (exptime_a == exptime_b) ?
                 (!DataCollection::defaultDataObjectComparator(a, b)) :
@@ -70,7 +87,175 @@ bool MediaCollection::exposureDateTimeAscendingComparator(DataObject* a,
 bool MediaCollection::exposureDateTimeDescendingComparator(DataObject* a,
                                                            DataObject* b)
 {
-    return !exposureDateTimeAscendingComparator(a, b);
+    return exposureDateTimeAscendingComparator(b, a);
+}
+
+/*!
+ * \brief MediaCollection::exposureDateTimeAscendingKey
+ * Sort key matching exposureDateTimeAscendingComparator(), which breaks ties
+ * with the higher DataObjectNumber first
+ * \param object
+ * \return
+ */
+quint64 MediaCollection::exposureDateTimeAscendingKey(DataObject* object)
+{
+    return packedSortKey(static_cast<MediaSource*>(object)->exposureMSecs(), object, false);
+}
+
+/*!
+ * \brief MediaCollection::exposureDateTimeDescendingKey
+ * \param object
+ * \return
+ */
+quint64 MediaCollection::exposureDateTimeDescendingKey(DataObject* object)
+{
+    return ~exposureDateTimeAscendingKey(object);
+}
+
+/*!
+ * \brief MediaCollection::fileTimestampDescendingComparator
+ * Newest files first
+ * \param a
+ * \param b
+ * \return
+ */
+bool MediaCollection::fileTimestampDescendingComparator(DataObject* a, DataObject* b)
+{
+    qint64 timestamp_a = static_cast<MediaSource*>(a)->fileTimestampMSecs();
+    qint64 timestamp_b = static_cast<MediaSource*>(b)->fileTimestampMSecs();
+
+    return (timestamp_a == timestamp_b) ?
+                DataCollection::defaultDataObjectComparator(a, b) :
+                (timestamp_a > timestamp_b);
+}
+
+/*!
+ * \brief MediaCollection::fileTimestampDescendingKey
+ * \param object
+ * \return
+ */
+quint64 MediaCollection::fileTimestampDescendingKey(DataObject* object)
+{
+    return ~packedSortKey(static_cast<MediaSource*>(object)->fileTimestampMSecs(), object, false);
+}
+
+/*!
+ * \brief MediaCollection::fileNameAscendingComparator
+ * Alphabetical by file name, ignoring case.  There is no sort key for this
+ * ordering, so collections using it fall back to the comparator.
+ * \param a
+ * \param b
+ * \return
+ */
+bool MediaCollection::fileNameAscendingComparator(DataObject* a, DataObject* b)
+{
+    int result = QString::compare(static_cast<MediaSource*>(a)->file().fileName(),
+                                  static_cast<MediaSource*>(b)->file().fileName(),
+                                  Qt::CaseInsensitive);
+
+    return (result == 0) ? DataCollection::defaultDataObjectComparator(a, b) : (result < 0);
+}
+
+/*!
+ * \brief MediaCollection::fileSizeDescendingComparator
+ * Largest files first
+ * \param a
+ * \param b
+ * \return
+ */
+bool MediaCollection::fileSizeDescendingComparator(DataObject* a, DataObject* b)
+{
+    qint64 size_a = static_cast<MediaSource*>(a)->fileSize();
+    qint64 size_b = static_cast<MediaSource*>(b)->fileSize();
+
+    return (size_a == size_b) ? DataCollection::defaultDataObjectComparator(a, b) : (size_a > size_b);
+}
+
+/*!
+ * \brief MediaCollection::fileSizeDescendingKey
+ * \param object
+ * \return
+ */
+quint64 MediaCollection::fileSizeDescendingKey(DataObject* object)
+{
+    return ~packedSortKey(static_cast<MediaSource*>(object)->fileSize(), object, false);
+}
+
+/*!
+ * \brief MediaCollection::pixelCountDescendingComparator
+ * Largest images first; media whose size isn't known yet sort last
+ * \param a
+ * \param b
+ * \return
+ */
+bool MediaCollection::pixelCountDescendingComparator(DataObject* a, DataObject* b)
+{
+    qint64 pixels_a = static_cast<MediaSource*>(a)->pixelCount();
+    qint64 pixels_b = static_cast<MediaSource*>(b)->pixelCount();
+
+    return (pixels_a == pixels_b) ? DataCollection::defaultDataObjectComparator(a, b) : (pixels_a > pixels_b);
+}
+
+/*!
+ * \brief MediaCollection::pixelCountDescendingKey
+ * \param object
+ * \return
+ */
+quint64 MediaCollection::pixelCountDescendingKey(DataObject* object)
+{
+    return ~packedSortKey(static_cast<MediaSource*>(object)->pixelCount(), object, false);
+}
+
+/*!
+ * \brief MediaCollection::comparatorFor
+ * \param order
+ * \return the comparator media is sorted with in the given order
+ */
+DataObjectComparator MediaCollection::comparatorFor(SortOrder order)
+{
+    switch (order) {
+    case FileTimestampOrder:
+        return fileTimestampDescendingComparator;
+
+    case FileNameOrder:
+        return fileNameAscendingComparator;
+
+    case FileSizeOrder:
+        return fileSizeDescendingComparator;
+
+    case PixelCountOrder:
+        return pixelCountDescendingComparator;
+
+    case ExposureDateTimeOrder:
+    default:
+        return exposureDateTimeDescendingComparator;
+    }
+}
+
+/*!
+ * \brief MediaCollection::sortedBy
+ * Returns all media in the given order.  Apart from the collection's own
+ * ordering, each order is held in a ViewCollection which is built (sorted)
+ * the first time it's asked for and then kept in step incrementally as media
+ * is added and removed, so views can switch between orders with
+ * ViewCollection::orderLike() instead of re-sorting.
+ * \param order
+ * \return
+ */
+const DataCollection* MediaCollection::sortedBy(SortOrder order)
+{
+    if (order == ExposureDateTimeOrder)
+        return this;
+
+    ViewCollection* index = m_sortIndexes.value(order, NULL);
+    if (index == NULL) {
+        index = new ViewCollection(QString("MediaCollection sort index %1").arg(order));
+        index->setComparator(comparatorFor(order));
+        index->monitorDataCollection(this, NULL, false);
+        m_sortIndexes.insert(order, index);
+    }
+
+    return index;
 }
 
 /*!
@@ -106,6 +291,12 @@ void MediaCollection::notifyContentsChanged(const QSet<DataObject*>* added,
                 m_fileMediaMap.insert(media->file().absoluteFilePath(), media);
                 QObject::connect(media, SIGNAL(busyChanged(bool)),
                                  this, SIGNAL(mediaIsBusy(bool)));
+                QObject::connect(media, SIGNAL(exposureDateTimeChanged()),
+                                 this, SLOT(onMediaSortDataChanged()));
+                QObject::connect(media, SIGNAL(sizeChanged()),
+                                 this, SLOT(onMediaSortDataChanged()));
+                QObject::connect(media, SIGNAL(dataChanged()),
+                                 this, SLOT(onMediaDataChanged()));
             }
         }
     }
@@ -120,6 +311,12 @@ void MediaCollection::notifyContentsChanged(const QSet<DataObject*>* added,
                 m_fileMediaMap.remove(media->file().absoluteFilePath());
                 QObject::disconnect(media, SIGNAL(busyChanged(bool)),
                                     this, SIGNAL(mediaIsBusy(bool)));
+                QObject::disconnect(media, SIGNAL(exposureDateTimeChanged()),
+                                    this, SLOT(onMediaSortDataChanged()));
+                QObject::disconnect(media, SIGNAL(sizeChanged()),
+                                    this, SLOT(onMediaSortDataChanged()));
+                QObject::disconnect(media, SIGNAL(dataChanged()),
+                                    this, SLOT(onMediaDataChanged()));
             }
 
             m_idMap.remove(media->id());
@@ -135,6 +332,33 @@ void MediaCollection::notifyContentsChanged(const QSet<DataObject*>* added,
         emit collectionChanged();
 }
 
+/*!
+ * \brief MediaCollection::onMediaSortDataChanged
+ * The exposure time and size are part of cached sort keys, so they have to be
+ * refreshed (and views monitoring this collection, sort indexes included,
+ * told of the change)
+ */
+void MediaCollection::onMediaSortDataChanged()
+{
+    MediaSource* media = qobject_cast<MediaSource*>(sender());
+    if (media == NULL)
+        return;
+
+    refreshSortKey(media);
+    notifyContentDataChanged(media);
+}
+
+/*!
+ * \brief MediaCollection::onMediaDataChanged
+ * Lets views (and the models over them) know the media's file changed
+ */
+void MediaCollection::onMediaDataChanged()
+{
+    MediaSource* media = qobject_cast<MediaSource*>(sender());
+    if (media != NULL)
+        notifyContentDataChanged(media);
+}
+
 /*!
  * \brief MediaCollection::photoFromFileinfo
  * Returns an existing photo object if we've already loaded one
@@ -30,6 +30,7 @@
 class DataObject;
 class MediaSource;
 class MediaTable;
+class ViewCollection;
 
 /*!
  * \brief The MediaCollection class
@@ -39,10 +40,33 @@ class MediaCollection : public SourceCollection
     Q_OBJECT
 
 public:
+    // The orders media can be browsed in; the default is the collection's own
+    enum SortOrder {
+        ExposureDateTimeOrder,
+        FileTimestampOrder,
+        FileNameOrder,
+        FileSizeOrder,
+        PixelCountOrder
+    };
+
     MediaCollection(MediaTable *mediaTable);
+    virtual ~MediaCollection();
 
     static bool exposureDateTimeAscendingComparator(DataObject* a, DataObject* b);
     static bool exposureDateTimeDescendingComparator(DataObject* a, DataObject* b);
+    static quint64 exposureDateTimeAscendingKey(DataObject* object);
+    static quint64 exposureDateTimeDescendingKey(DataObject* object);
+
+    static bool fileTimestampDescendingComparator(DataObject* a, DataObject* b);
+    static quint64 fileTimestampDescendingKey(DataObject* object);
+    static bool fileNameAscendingComparator(DataObject* a, DataObject* b);
+    static bool fileSizeDescendingComparator(DataObject* a, DataObject* b);
+    static quint64 fileSizeDescendingKey(DataObject* object);
+    static bool pixelCountDescendingComparator(DataObject* a, DataObject* b);
+    static quint64 pixelCountDescendingKey(DataObject* object);
+
+    static DataObjectComparator comparatorFor(SortOrder order);
+    const DataCollection* sortedBy(SortOrder order);
 
     MediaSource* mediaForId(qint64 id);
     const MediaSource* mediaFromFileinfo(const QFileInfo &file) const;
@@ -63,12 +87,18 @@ protected slots:
                                        const QSet<DataObject*>* removed,
                                        bool notify);
 
+private slots:
+    void onMediaSortDataChanged();
+    void onMediaDataChanged();
+
 private:
     // Used by photoFromFileinfo() to prevent ourselves from accidentally
     // seeing a duplicate photo after an edit.
     QHash<QString, MediaSource*> m_fileMediaMap;
     QHash<qint64, DataObject*> m_idMap;
     MediaTable *m_mediaTable;
+    // Secondary orderings, each kept up to date as media comes and goes
+    QHash<int, ViewCollection*> m_sortIndexes;
 };
 
 #endif  // GALLERY_MEDIA_COLLECTION_H_
@@ -25,12 +25,18 @@
 
 #include <QUrl>
 
+#include <limits>
+
 /*!
  * \brief MediaSource::MediaSource
  */
 MediaSource::MediaSource()
-    : m_id(INVALID_ID),
+    : m_lastModified(std::numeric_limits<qint64>::min()),
+      m_id(INVALID_ID),
       m_exposureDateTime(),
+      m_exposureMSecs(std::numeric_limits<qint64>::min()),
+      m_fileTimestampMSecs(std::numeric_limits<qint64>::min()),
+      m_fileSize(0),
       m_busy(false),
       m_mediaTable(0)
 {
@@ -41,12 +47,17 @@ MediaSource::MediaSource()
  * \param file
  */
 MediaSource::MediaSource(const QFileInfo& file)
-    : m_id(INVALID_ID),
+    : m_lastModified(std::numeric_limits<qint64>::min()),
+      m_id(INVALID_ID),
       m_exposureDateTime(),
+      m_exposureMSecs(std::numeric_limits<qint64>::min()),
+      m_fileTimestampMSecs(std::numeric_limits<qint64>::min()),
+      m_fileSize(0),
       m_busy(false),
       m_mediaTable(0)
 {
     m_file = file;
+    m_path = QUrl::fromLocalFile(m_file.absoluteFilePath());
 }
 
 /*!
@@ -73,16 +84,21 @@ QFileInfo MediaSource::file() const
  */
 QUrl MediaSource::path() const
 {
-    return QUrl::fromLocalFile(m_file.absoluteFilePath());
+    return m_path;
 }
 
 /*!
  * \brief MediaSource::lastModified
+ * The file is only stat'ed the first time this is asked for after
+ * construction or refresh()
  * \return
  */
 qint64 MediaSource::lastModified() const
 {
-    return m_file.lastModified().toMSecsSinceEpoch();
+    if (m_lastModified == std::numeric_limits<qint64>::min())
+        m_lastModified = m_file.lastModified().toMSecsSinceEpoch();
+
+    return m_lastModified;
 }
 
 /*!
@@ -128,6 +144,12 @@ void MediaSource::setExposureDateTime(const QDateTime& exposureTime)
         return;
 
     m_exposureDateTime = exposureTime;
+
+    // Cached so comparators need not convert the QDateTime on every comparison;
+    // an unset exposure time sorts before all others
+    m_exposureMSecs = exposureTime.isValid() ? exposureTime.toMSecsSinceEpoch()
+                                             : std::numeric_limits<qint64>::min();
+
     emit exposureDateTimeChanged();
 }
 
@@ -147,6 +169,35 @@ const QDateTime &MediaSource::fileTimestamp() const
 void MediaSource::setFileTimestamp(const QDateTime& timestamp)
 {
     m_fileTimestamp = timestamp;
+    m_fileTimestampMSecs = timestamp.isValid() ? timestamp.toMSecsSinceEpoch()
+                                               : std::numeric_limits<qint64>::min();
+}
+
+/*!
+ * \brief MediaSource::fileTimestampMSecs
+ * \return the timestamp of the media file as milliseconds since the epoch
+ */
+qint64 MediaSource::fileTimestampMSecs() const
+{
+    return m_fileTimestampMSecs;
+}
+
+/*!
+ * \brief MediaSource::fileSize
+ * \return the size of the media file in bytes
+ */
+qint64 MediaSource::fileSize() const
+{
+    return m_fileSize;
+}
+
+/*!
+ * \brief MediaSource::setFileSize
+ * \param fileSize
+ */
+void MediaSource::setFileSize(qint64 fileSize)
+{
+    m_fileSize = fileSize;
 }
 
 /*!
@@ -165,6 +216,16 @@ const QSize& MediaSource::size()
     return m_size;
 }
 
+/*!
+ * \brief MediaSource::pixelCount
+ * Unlike size(), never loads the image
+ * \return the number of pixels, or 0 if the size is not known yet
+ */
+qint64 MediaSource::pixelCount() const
+{
+    return isSizeSet() ? (qint64) m_size.width() * m_size.height() : 0;
+}
+
 /*!
  * \brief MediaSource::set_size
  * \param size
@@ -214,6 +275,15 @@ int MediaSource::exposureTime_t() const
     return (int) exposureDateTime().toTime_t();
 }
 
+/*!
+ * \brief MediaSource::exposureMSecs
+ * \return the exposure time as milliseconds since the epoch
+ */
+qint64 MediaSource::exposureMSecs() const
+{
+    return m_exposureMSecs;
+}
+
 /*!
  * \brief MediaSource::busy
  * \return
@@ -257,6 +327,7 @@ qint64 MediaSource::id() const
 void MediaSource::refresh()
 {
     m_file.refresh();
+    m_lastModified = std::numeric_limits<qint64>::min();
 }
 
 /*!
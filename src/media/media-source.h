@@ -89,12 +89,18 @@ public:
     QDate exposureDate() const;
     QTime exposureTimeOfDay() const;
     int exposureTime_t() const;
+    qint64 exposureMSecs() const;
     void setExposureDateTime(const QDateTime& exposureTime);
 
     const QDateTime& fileTimestamp() const;
+    qint64 fileTimestampMSecs() const;
     void setFileTimestamp(const QDateTime& timestamp);
 
+    qint64 fileSize() const;
+    void setFileSize(qint64 fileSize);
+
     const QSize& size();
+    qint64 pixelCount() const;
 
     qint64 id() const;
     void setId(qint64 id);
@@ -128,10 +134,15 @@ private:
     }
 
     QFileInfo m_file;
+    QUrl m_path;
+    mutable qint64 m_lastModified;
     qint64 m_id;
     QSize m_size;
     QDateTime m_exposureDateTime;
+    qint64 m_exposureMSecs;
     QDateTime m_fileTimestamp;
+    qint64 m_fileTimestampMSecs;
+    qint64 m_fileSize;
     bool m_busy;
     MediaTable *m_mediaTable;
 };
@@ -19,8 +19,12 @@
 
 #include "photo-metadata.h"
 
+// util
+#include "jpeg-orientation.h"
+
 #include <cstdio>
 #include <QBuffer>
+#include <QImageReader>
 
 namespace {
 const Orientation DEFAULT_ORIENTATION = TOP_LEFT_ORIGIN;
@@ -100,7 +104,9 @@ QDateTime parse_exif_date_string(const char* s) {
  * \param filepath
  */
 PhotoMetadata::PhotoMetadata(const char* filepath)
-    : m_fileSourceInfo(filepath)
+    : m_fileSourceInfo(filepath),
+      m_orientationChanged(false),
+      m_otherMetadataChanged(false)
 {
     m_image = Exiv2::ImageFactory::open(filepath);
     m_image->readMetadata();
@@ -223,6 +229,8 @@ void PhotoMetadata::setOrientation(Orientation orientation)
 
     if (!m_keysPresent.contains(EXIF_ORIENTATION_KEY))
         m_keysPresent.insert(EXIF_ORIENTATION_KEY);
+
+    m_orientationChanged = true;
 }
 
 /*!
@@ -243,6 +251,8 @@ void PhotoMetadata::setDateTimeDigitized(const QDateTime& digitized)
  
         if (!m_keysPresent.contains(EXIF_DATETIMEDIGITIZED_KEY))
             m_keysPresent.insert(EXIF_DATETIMEDIGITIZED_KEY);
+
+        m_otherMetadataChanged = true;
  
     } catch (Exiv2::AnyError& e) {
         qDebug("Do not set DateTimeDigitized, error reading image metadata; %s", e.what());
@@ -252,12 +262,23 @@ void PhotoMetadata::setDateTimeDigitized(const QDateTime& digitized)
 
 /*!
  * \brief PhotoMetadata::save
+ * When only the orientation has changed and the file already has one, it's
+ * overwritten where it is rather than having Exiv2 rewrite the file.
  * \return
  */
 bool PhotoMetadata::save() const
 {
+    if (m_orientationChanged && !m_otherMetadataChanged &&
+            JpegOrientation::patchOrientation(m_fileSourceInfo.absoluteFilePath(),
+                                              orientation())) {
+        m_orientationChanged = false;
+        return true;
+    }
+
     try {
         m_image->writeMetadata();
+        m_orientationChanged = false;
+        m_otherMetadataChanged = false;
         return true;
     } catch (Exiv2::AnyError& e) {
         return false;
@@ -267,15 +288,29 @@ bool PhotoMetadata::save() const
 void PhotoMetadata::copyTo(PhotoMetadata *other) const
 {
     other->m_image->setMetadata(*m_image);
+    other->m_otherMetadataChanged = true;
 }
 
-void PhotoMetadata::updateThumbnail(QImage image)
+bool PhotoMetadata::updateThumbnail()
 {
-    QImage scaled = image.scaled(image.width() / THUMBNAIL_SCALE,
-                                 image.height() / THUMBNAIL_SCALE);
+    // The file is decoded straight at the thumbnail's size, which for a JPEG
+    // means a reduced DCT scale, so the full size image is never held
+    QImageReader reader(m_fileSourceInfo.absoluteFilePath());
+    QSize size = reader.size();
+    if (!size.isValid())
+        return false;
+
+    reader.setScaledSize((size / THUMBNAIL_SCALE).expandedTo(QSize(1, 1)));
+    QImage scaled = reader.read();
+    if (scaled.isNull())
+        return false;
+
     QBuffer jpeg;
     jpeg.open(QIODevice::WriteOnly);
     scaled.save(&jpeg, "jpeg");
     Exiv2::ExifThumb thumb(m_image->exifData());
     thumb.setJpegThumbnail((Exiv2::byte*) jpeg.data().constData(), jpeg.size());
+    m_otherMetadataChanged = true;
+
+    return true;
 }
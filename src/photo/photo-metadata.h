@@ -52,7 +52,7 @@ public:
     void setOrientation(Orientation orientation);
     void setDateTimeDigitized(const QDateTime& digitized);
 
-    void updateThumbnail(QImage image);
+    bool updateThumbnail();
     void copyTo(PhotoMetadata* other) const;
     bool save() const;
 
@@ -62,6 +62,8 @@ private:
     Exiv2::Image::AutoPtr m_image;
     QSet<QString> m_keysPresent;
     QFileInfo m_fileSourceInfo;
+    mutable bool m_orientationChanged;
+    mutable bool m_otherMetadataChanged;
 };
 
 #endif // GALLERY_PHOTO_METADATA_H_
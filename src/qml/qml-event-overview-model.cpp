@@ -25,6 +25,9 @@
 #include "variants.h"
 #include "gallery-manager.h"
 
+#include <algorithm>
+#include <limits>
+
 /*!
  * \brief QmlEventOverviewModel::QmlEventOverviewModel
  * \param parent
@@ -33,6 +36,9 @@ QmlEventOverviewModel::QmlEventOverviewModel(QObject* parent)
     : QmlMediaCollectionModel(parent, descendingComparator),
       m_ascendingOrder(false), m_syncingMedia(false)
 {
+    DataCollection::registerSortKey(ascendingComparator, ascendingKey);
+    DataCollection::registerSortKey(descendingComparator, descendingKey);
+
     // initialize ViewCollection as it stands now with Events
     monitorNewViewCollection();
 
@@ -123,9 +129,23 @@ void QmlEventOverviewModel::monitorNewViewCollection()
 
     QObject::connect(
                 backingViewCollection(),
-                SIGNAL(selectionChanged(const QSet<DataObject*>*,const QSet<DataObject*>*)),
+                SIGNAL(contentsRangesChanged(const DataCollectionDelta*, bool)),
+                this,
+                SLOT(onEventOverviewContentsRangesChanged(const DataCollectionDelta*, bool)));
+
+    QObject::connect(
+                backingViewCollection(),
+                SIGNAL(selectionRangesChanged(const QList<DataIndexRange>*, bool)),
                 this,
-                SLOT(onEventOverviewSelectionChanged(const QSet<DataObject*>*,const QSet<DataObject*>*)));
+                SLOT(onEventOverviewSelectionRangesChanged(const QList<DataIndexRange>*, bool)));
+
+    QObject::connect(
+                backingViewCollection(),
+                SIGNAL(orderingChanged()),
+                this,
+                SLOT(onEventOverviewOrderingChanged()));
+
+    rebuildSections();
 
     // seed existing contents with Events
     onEventOverviewContentsChanged(&backingViewCollection()->getAsSet(), NULL, true);
@@ -173,47 +193,124 @@ void QmlEventOverviewModel::onEventOverviewContentsChanged(
     SelectableViewCollection* view = backingViewCollection();
 
     if (added != NULL) {
+        EventCollection* events = GalleryManager::instance()->eventCollection();
+
+        // gather the missing Events first, so they go in with a single
+        // merge rather than one insertion per media
+        QSet<DataObject*> missing;
         DataObject* object;
         foreach (object, *added) {
             MediaSource* source = qobject_cast<MediaSource*>(object);
             if (source == NULL)
                 continue;
 
-            QDate source_date = source->exposureDateTime().date();
-            Event* event = GalleryManager::instance()->eventCollection()->eventForDate(source_date);
+            Event* event = events->eventForMediaSource(source);
             Q_ASSERT(event != NULL);
 
             if (!view->contains(event))
-                view->add(event);
+                missing.insert(event);
         }
+
+        if (!missing.isEmpty())
+            view->addMany(missing);
     }
 }
 
 /*!
- * \brief QmlEventOverviewModel::onEventOverviewSelectionChanged
- * \param selected
- * \param unselected
+ * \brief QmlEventOverviewModel::onEventOverviewContentsRangesChanged
+ * Moves the section starts along with the DataObjects and recounts only the
+ * sections whose media changed
+ * \param delta
+ * \param notify
  */
-void QmlEventOverviewModel::onEventOverviewSelectionChanged(
-        const QSet<DataObject*>* selected, const QSet<DataObject*>* unselected)
+void QmlEventOverviewModel::onEventOverviewContentsRangesChanged(
+        const DataCollectionDelta* delta, bool notify)
 {
-    // if an Event is selected, select all photos in that date
-    syncSelectedMedia(selected, true);
+    Q_UNUSED(notify);
+
+    SelectableViewCollection* view = backingViewCollection();
+    QVector<bool> dirty(m_sectionStarts.count(), false);
+
+    // descending, so each range is still at its old indexes when reached
+    foreach (const DataIndexRange& range, delta->removed) {
+        int length = range.second - range.first + 1;
+        int from = std::lower_bound(m_sectionStarts.constBegin(), m_sectionStarts.constEnd(), range.first)
+                - m_sectionStarts.constBegin();
+        int to = std::upper_bound(m_sectionStarts.constBegin(), m_sectionStarts.constEnd(), range.second)
+                - m_sectionStarts.constBegin();
+
+        m_sectionStarts.remove(from, to - from);
+        m_sectionSelected.remove(from, to - from);
+        dirty.remove(from, to - from);
+        for (int section = from; section < m_sectionStarts.count(); ++section)
+            m_sectionStarts[section] -= length;
+
+        // the section before the gap loses media, or takes over the media of
+        // the Events removed
+        if (from > 0)
+            dirty[from - 1] = true;
+    }
+
+    // ascending, so everything before each range is already in place
+    foreach (const DataIndexRange& range, delta->inserted) {
+        int length = range.second - range.first + 1;
+        int section = std::lower_bound(m_sectionStarts.constBegin(), m_sectionStarts.constEnd(), range.first)
+                - m_sectionStarts.constBegin();
+        for (int later = section; later < m_sectionStarts.count(); ++later)
+            m_sectionStarts[later] += length;
+
+        if (section > 0)
+            dirty[section - 1] = true;
+
+        for (int index = range.first; index <= range.second; ++index) {
+            if (qobject_cast<Event*>(view->getAt(index)) == NULL)
+                continue;
 
-    // if an Event is unselected, unselect all photos in that date
-    syncSelectedMedia(unselected, false);
+            m_sectionStarts.insert(section, index);
+            m_sectionSelected.insert(section, 0);
+            dirty.insert(section, true);
+            ++section;
+        }
+    }
+
+    for (int section = 0; section < dirty.count(); ++section) {
+        if (dirty[section])
+            recountSection(section);
+    }
 }
 
 /*!
- * \brief QmlEventOverviewModel::syncSelectedMedia
- * \param toggled
+ * \brief QmlEventOverviewModel::onEventOverviewSelectionRangesChanged
+ * Keeps the per section counts up to date, and when the user (un)selects an
+ * Event (un)selects its media with it, or when the user (un)selects media
+ * decides from the count whether their Event is selected
+ * \param ranges
  * \param selected
  */
-void QmlEventOverviewModel::syncSelectedMedia(const QSet<DataObject*>* toggled,
-                                              bool selected)
+void QmlEventOverviewModel::onEventOverviewSelectionRangesChanged(
+        const QList<DataIndexRange>* ranges, bool selected)
 {
-    if (toggled == NULL)
-        return;
+    QList<int> toggledEvents;
+    QList<int> toggledMedia;
+
+    foreach (const DataIndexRange& range, *ranges) {
+        int section = qMax(sectionAt(range.first), 0);
+        for (; section < m_sectionStarts.count() && m_sectionStarts[section] <= range.second;
+             ++section) {
+            int start = m_sectionStarts[section];
+            if (range.first <= start)
+                toggledEvents.append(section);
+
+            int first = qMax(range.first, start + 1);
+            int last = qMin(range.second, sectionEnd(section) - 1);
+            if (first > last)
+                continue;
+
+            m_sectionSelected[section] += selected ? (last - first + 1) : -(last - first + 1);
+            if (toggledMedia.isEmpty() || toggledMedia.last() != section)
+                toggledMedia.append(section);
+        }
+    }
 
     // Don't recurse -- only take action from the selection made by the user, not
     // any other selections we've done internally.
@@ -223,79 +320,91 @@ void QmlEventOverviewModel::syncSelectedMedia(const QSet<DataObject*>* toggled,
     m_syncingMedia = true;
 
     SelectableViewCollection* view = backingViewCollection();
-    int count = view->count();
-
-    // Walk the toggle group looking for Event's; when found, walk all the
-    // MediaSources that follow and select or unselect them; when another
-    // Event is found (or end of list), exit
-    //
-    // TODO: Select/Unselect in bulk operations for efficiency
-    DataObject* object;
-    foreach (object, *toggled) {
-        Event* event = qobject_cast<Event*>(object);
-        if (event == NULL)
+
+    foreach (int section, toggledEvents) {
+        if (selected)
+            view->selectRange(m_sectionStarts[section] + 1, sectionEnd(section) - 1);
+        else
+            view->unselectRange(m_sectionStarts[section] + 1, sectionEnd(section) - 1);
+    }
+
+    foreach (int section, toggledMedia) {
+        if (toggledEvents.contains(section))
             continue;
 
-        int index = view->indexOf(event);
-        for (int ctr = index + 1; ctr < count; ctr++) {
-            MediaSource* media = qobject_cast<MediaSource*>(view->getAt(ctr));
-            if (media == NULL)
-                break;
+        int start = m_sectionStarts[section];
+        bool all_selected = (m_sectionSelected[section] == sectionEnd(section) - start - 1);
 
-            if (selected)
-                view->select(media);
-            else
-                view->unselect(media);
-        }
+        if (selected && all_selected)
+            view->selectRange(start, start);
+        else if (!selected)
+            view->unselectRange(start, start);
     }
 
-    // The other case is when the user is selecting or deselecting media.  We
-    // walk around looking for other media to see if we should select or deselect
-    // the containing event.
-    //
-    // TODO: Select/Unselect in bulk operations for efficiency
-    foreach (object, *toggled) {
-        MediaSource* media = qobject_cast<MediaSource*>(object);
-        if (media == NULL)
-            break;
-
-        int index = view->indexOf(media);
-        bool all_match_selection = true;
-
-        // First walk forward to the next event/end of list looking for differing
-        // selection states in other media.
-        for (int i = index + 1; i < count; ++i) {
-            MediaSource* media = qobject_cast<MediaSource*>(view->getAt(i));
-            if (media == NULL)
-                break;
-
-            if (view->isSelected(media) != selected) {
-                all_match_selection = false;
-                break;
-            }
-        }
+    m_syncingMedia = false;
+}
 
-        // Now walk backwards also checking media, and looking for the event.
-        for (int i = index - 1; i >= 0; --i) {
-            MediaSource* media = qobject_cast<MediaSource*>(view->getAt(i));
-            Event* event = qobject_cast<Event*>(view->getAt(i));
-
-            if (media != NULL) {
-                if (view->isSelected(media) != selected)
-                    all_match_selection = false;
-            }
-
-            if (event != NULL) {
-                if (all_match_selection && selected)
-                    view->select(event);
-                else
-                    view->unselect(event);
-                break;
-            }
-        }
+/*!
+ * \brief QmlEventOverviewModel::onEventOverviewOrderingChanged
+ */
+void QmlEventOverviewModel::onEventOverviewOrderingChanged()
+{
+    rebuildSections();
+}
+
+/*!
+ * \brief QmlEventOverviewModel::rebuildSections
+ */
+void QmlEventOverviewModel::rebuildSections()
+{
+    m_sectionStarts.clear();
+    m_sectionSelected.clear();
+
+    SelectableViewCollection* view = backingViewCollection();
+    if (view == NULL)
+        return;
+
+    for (int index = 0; index < view->count(); ++index) {
+        if (qobject_cast<Event*>(view->getAt(index)) != NULL)
+            m_sectionStarts.append(index);
     }
 
-    m_syncingMedia = false;
+    m_sectionSelected.fill(0, m_sectionStarts.count());
+    for (int section = 0; section < m_sectionStarts.count(); ++section)
+        recountSection(section);
+}
+
+/*!
+ * \brief QmlEventOverviewModel::recountSection
+ * \param section
+ */
+void QmlEventOverviewModel::recountSection(int section)
+{
+    m_sectionSelected[section] = backingViewCollection()->selectedCount(
+                m_sectionStarts[section] + 1, sectionEnd(section) - 1);
+}
+
+/*!
+ * \brief QmlEventOverviewModel::sectionAt
+ * \param index
+ * \return the section holding the index, or -1 if it comes before the first
+ * Event
+ */
+int QmlEventOverviewModel::sectionAt(int index) const
+{
+    return (std::upper_bound(m_sectionStarts.constBegin(), m_sectionStarts.constEnd(), index)
+            - m_sectionStarts.constBegin()) - 1;
+}
+
+/*!
+ * \brief QmlEventOverviewModel::sectionEnd
+ * \param section
+ * \return the index just past the section's last media
+ */
+int QmlEventOverviewModel::sectionEnd(int section) const
+{
+    return (section + 1 < m_sectionStarts.count())
+            ? m_sectionStarts[section + 1] : backingViewCollection()->count();
 }
 
 /*!
@@ -329,42 +438,63 @@ bool QmlEventOverviewModel::descendingComparator(DataObject* a, DataObject* b)
  */
 bool QmlEventOverviewModel::eventComparator(DataObject* a, DataObject* b, bool asc)
 {
-    QDateTime atime = objectDateTime(a, asc);
-    QDateTime btime = objectDateTime(b, asc);
+    // descending order is the ascending order (by the Events' end times)
+    // reversed; swapping the operands keeps the comparison strict
+    if (!asc)
+        qSwap(a, b);
+
+    qint64 atime = objectMSecs(a, asc);
+    qint64 btime = objectMSecs(b, asc);
 
-    // use default comparator to stabilize order (reversing comparison for descending
-    // order)
-    bool lessThan;
+    // use default comparator to stabilize order
     if (atime != btime)
-        lessThan = atime < btime;
-    else
-        lessThan = DataCollection::defaultDataObjectComparator(a, b);
+        return atime < btime;
+
+    return DataCollection::defaultDataObjectComparator(a, b);
+}
+
+/*!
+ * \brief QmlEventOverviewModel::ascendingKey
+ * \param object
+ * \return sort key matching ascendingComparator()
+ */
+quint64 QmlEventOverviewModel::ascendingKey(DataObject* object)
+{
+    return DataCollection::packedSortKey(objectMSecs(object, true), object, true);
+}
 
-    return (asc) ? lessThan : !lessThan;
+/*!
+ * \brief QmlEventOverviewModel::descendingKey
+ * \param object
+ * \return sort key matching descendingComparator()
+ */
+quint64 QmlEventOverviewModel::descendingKey(DataObject* object)
+{
+    return ~DataCollection::packedSortKey(objectMSecs(object, false), object, true);
 }
 
 /*!
- * \brief QmlEventOverviewModel::objectDateTime
+ * \brief QmlEventOverviewModel::objectMSecs
  * Since items in the list can be either a MediaSource or an Event,
  * determine dynamically and compare.  Since going in reverse chronological order,
  * use the event's end date/time for comparison (to place it before everything
  * else inside of it)
  * \param object
  * \param asc
- * \return
+ * \return milliseconds since the epoch
  */
-QDateTime QmlEventOverviewModel::objectDateTime(DataObject* object, bool asc)
+qint64 QmlEventOverviewModel::objectMSecs(DataObject* object, bool asc)
 {
     MediaSource* media = qobject_cast<MediaSource*>(object);
     if (media != NULL)
-        return media->exposureDateTime();
+        return media->exposureMSecs();
 
     // Events are different depending on ascending vs. descending; they should
     // always be at the head of the MediaSource span, so they need to use different
     // times to ensure that
     Event* event = qobject_cast<Event*>(object);
     if (event != NULL)
-        return asc ? event->startDateTime() : event->endDateTime();
+        return asc ? event->startMSecs() : event->endMSecs();
 
-    return QDateTime();
+    return std::numeric_limits<qint64>::min();
 }
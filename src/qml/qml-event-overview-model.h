@@ -24,6 +24,7 @@
 #include <QDateTime>
 #include <QSet>
 #include <QVariant>
+#include <QVector>
 #include <QtQml>
 
 #include "qml-media-collection-model.h"
@@ -62,20 +63,32 @@ private slots:
     void onEventOverviewContentsChanged(const QSet<DataObject*>* added,
                                         const QSet<DataObject*>* removed,
                                         bool notify);
-    void onEventOverviewSelectionChanged(const QSet<DataObject*>* selected,
-                                         const QSet<DataObject*>* unselected);
+    void onEventOverviewContentsRangesChanged(const DataCollectionDelta* delta,
+                                              bool notify);
+    void onEventOverviewSelectionRangesChanged(const QList<DataIndexRange>* ranges,
+                                               bool selected);
+    void onEventOverviewOrderingChanged();
 
 private:
     static bool ascendingComparator(DataObject* a, DataObject* b);
     static bool descendingComparator(DataObject* a, DataObject* b);
     static bool eventComparator(DataObject* a, DataObject* b, bool desc);
-    static QDateTime objectDateTime(DataObject* object, bool desc);
+    static quint64 ascendingKey(DataObject* object);
+    static quint64 descendingKey(DataObject* object);
+    static qint64 objectMSecs(DataObject* object, bool asc);
 
     void monitorNewViewCollection();
-    void syncSelectedMedia(const QSet<DataObject*>* toggled, bool selected);
+    void rebuildSections();
+    void recountSection(int section);
+    int sectionAt(int index) const;
+    int sectionEnd(int section) const;
 
     bool m_ascendingOrder;
     bool m_syncingMedia;
+    // each Event's index in the view, followed by its media up to the next
+    // one, and how many of those media are selected
+    QVector<int> m_sectionStarts;
+    QVector<int> m_sectionSelected;
 };
 
 QML_DECLARE_TYPE(QmlEventOverviewModel)
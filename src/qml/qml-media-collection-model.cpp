@@ -48,7 +48,8 @@
  * \param parent
  */
 QmlMediaCollectionModel::QmlMediaCollectionModel(QObject* parent)
-    : QmlViewCollectionModel(parent, "mediaSource", NULL)
+    : QmlViewCollectionModel(parent, "mediaSource", NULL),
+      m_sortOrder(DefaultOrder)
 {
 }
 
@@ -59,7 +60,8 @@ QmlMediaCollectionModel::QmlMediaCollectionModel(QObject* parent)
  */
 QmlMediaCollectionModel::QmlMediaCollectionModel(QObject* parent,
                                                  DataObjectComparator default_comparator)
-    : QmlViewCollectionModel(parent, "mediaSource", default_comparator)
+    : QmlViewCollectionModel(parent, "mediaSource", default_comparator),
+      m_sortOrder(DefaultOrder)
 {
 }
 
@@ -133,6 +135,41 @@ void QmlMediaCollectionModel::removeMediaFromAlbum(QVariant valbum, QVariant vme
     album->detach(media, true);
 }
 
+/*!
+ * \brief QmlMediaCollectionModel::setVisibleRange is called by the views as
+ * they scroll, so that media still being loaded around the rows on screen are
+ * given precedence. A range with a negative or out of order end is ignored,
+ * rather than widened to the whole model
+ * \param first the first visible row
+ * \param last the last visible row
+ */
+void QmlMediaCollectionModel::setVisibleRange(int first, int last)
+{
+    int rows = count();
+    if (first < 0 || last < first || first >= rows)
+        return;
+
+    last = qMin(last, rows - 1);
+
+    qint64 first_msecs = 0;
+    qint64 last_msecs = 0;
+    bool found = false;
+    for (int row = first; row <= last; ++row) {
+        int real_index = viewIndex(index(row, 0));
+        if (real_index < 0)
+            continue;
+
+        qint64 msecs = static_cast<MediaSource*>(
+                    backingViewCollection()->getAt(real_index))->exposureMSecs();
+        first_msecs = found ? qMin(first_msecs, msecs) : msecs;
+        last_msecs = found ? qMax(last_msecs, msecs) : msecs;
+        found = true;
+    }
+
+    if (found)
+        GalleryManager::instance()->setMediaViewport(first_msecs, last_msecs);
+}
+
 /*!
  * \brief QmlMediaCollectionModel::monitored
  * \return
@@ -159,6 +196,68 @@ void QmlMediaCollectionModel::setMonitored(bool monitor)
     monitoringChanged();
 }
 
+/*!
+ * \brief QmlMediaCollectionModel::sortOrder
+ * \return
+ */
+QmlMediaCollectionModel::SortOrder QmlMediaCollectionModel::sortOrder() const
+{
+    return m_sortOrder;
+}
+
+/*!
+ * \brief QmlMediaCollectionModel::setSortOrder
+ * Switching orders takes the new order from the MediaCollection's
+ * maintained sort indexes rather than re-sorting the view
+ * \param order
+ */
+void QmlMediaCollectionModel::setSortOrder(SortOrder order)
+{
+    if (m_sortOrder == order)
+        return;
+
+    // models with their own comparator don't follow the monitored ordering
+    if (defaultComparator() != NULL) {
+        qDebug("sortOrder is only supported for models following the collection's ordering");
+
+        return;
+    }
+
+    m_sortOrder = order;
+    applySortOrder();
+
+    emit sortOrderChanged();
+}
+
+/*!
+ * \brief QmlMediaCollectionModel::notifyBackingCollectionChanged
+ */
+void QmlMediaCollectionModel::notifyBackingCollectionChanged()
+{
+    // a fresh view follows the monitored collection's ordering
+    if (m_sortOrder != DefaultOrder)
+        applySortOrder();
+
+    QmlViewCollectionModel::notifyBackingCollectionChanged();
+}
+
+/*!
+ * \brief QmlMediaCollectionModel::applySortOrder
+ */
+void QmlMediaCollectionModel::applySortOrder()
+{
+    SelectableViewCollection* view = backingViewCollection();
+    if (view == NULL || !view->isMonitoring())
+        return;
+
+    if (m_sortOrder == DefaultOrder) {
+        view->orderLike(view->collection());
+    } else {
+        MediaCollection* media = GalleryManager::instance()->mediaCollection();
+        view->orderLike(media->sortedBy((MediaCollection::SortOrder) m_sortOrder));
+    }
+}
+
 /*!
  * \brief QmlMediaCollectionModel::toVariant
  * \param object
@@ -181,6 +280,58 @@ DataObject* QmlMediaCollectionModel::fromVariant(QVariant var) const
     return UncheckedVariantToObject<MediaSource*>(var);
 }
 
+/*!
+ * \brief QmlMediaCollectionModel::data
+ * \param index
+ * \param role
+ * \return
+ */
+QVariant QmlMediaCollectionModel::data(const QModelIndex& index, int role) const
+{
+    if (role < MediaPathRole || role > MediaOrientationRole)
+        return QmlViewCollectionModel::data(index, role);
+
+    int real_index = viewIndex(index);
+    if (real_index < 0)
+        return QVariant();
+
+    const MediaSource* media = static_cast<MediaSource*>(backingViewCollection()->getAt(real_index));
+
+    switch (role) {
+    case MediaPathRole:
+        return QVariant(media->path());
+
+    case MediaLastModifiedRole:
+        return QVariant(media->lastModified());
+
+    case MediaTypeRole:
+        return QVariant(static_cast<int>(media->type()));
+
+    case MediaExposureMSecsRole:
+        return QVariant(media->exposureMSecs());
+
+    case MediaOrientationRole:
+    default:
+        return QVariant(static_cast<int>(media->orientation()));
+    }
+}
+
+/*!
+ * \brief QmlMediaCollectionModel::roleNames
+ * \return
+ */
+QHash<int, QByteArray> QmlMediaCollectionModel::roleNames() const
+{
+    QHash<int, QByteArray> roles = QmlViewCollectionModel::roleNames();
+    roles.insert(MediaPathRole, "mediaPath");
+    roles.insert(MediaLastModifiedRole, "mediaLastModified");
+    roles.insert(MediaTypeRole, "mediaType");
+    roles.insert(MediaExposureMSecsRole, "mediaExposureMSecs");
+    roles.insert(MediaOrientationRole, "mediaOrientation");
+
+    return roles;
+}
+
 /*!
  * \brief QmlMediaCollectionModel::isAccepted
  * \param item
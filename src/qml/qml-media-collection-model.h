@@ -27,6 +27,9 @@
 
 #include "qml-view-collection-model.h"
 
+// media
+#include "media-collection.h"
+
 class DataObject;
 
 /*!
@@ -37,11 +40,34 @@ class QmlMediaCollectionModel : public QmlViewCollectionModel
     Q_OBJECT
     Q_PROPERTY(bool monitored READ monitored WRITE setMonitored
                NOTIFY monitoringChanged)
+    Q_PROPERTY(SortOrder sortOrder READ sortOrder WRITE setSortOrder
+               NOTIFY sortOrderChanged)
+    Q_ENUMS(SortOrder)
 
 signals:
     void monitoringChanged();
+    void sortOrderChanged();
 
 public:
+    // DefaultOrder follows the ordering of the monitored collection
+    enum SortOrder {
+        DefaultOrder = MediaCollection::ExposureDateTimeOrder,
+        FileTimestampOrder = MediaCollection::FileTimestampOrder,
+        FileNameOrder = MediaCollection::FileNameOrder,
+        FileSizeOrder = MediaCollection::FileSizeOrder,
+        PixelCountOrder = MediaCollection::PixelCountOrder
+    };
+
+    // Read straight from the MediaSource's cached values, so delegates don't
+    // have to go through its properties
+    enum MediaRole {
+        MediaPathRole = LastCommonRole,
+        MediaLastModifiedRole,
+        MediaTypeRole,
+        MediaExposureMSecsRole,
+        MediaOrientationRole
+    };
+
     QmlMediaCollectionModel(QObject* parent = NULL);
     QmlMediaCollectionModel(QObject* parent, DataObjectComparator defaultComparator);
 
@@ -49,14 +75,27 @@ public:
     Q_INVOKABLE void destroySelectedMedia();
     Q_INVOKABLE void destroyMedia(QVariant vmedia, bool destroy_backing);
     Q_INVOKABLE void removeMediaFromAlbum(QVariant valbum, QVariant vmedia);
+    Q_INVOKABLE void setVisibleRange(int first, int last);
 
     bool monitored() const;
     void setMonitored(bool monitor);
+    SortOrder sortOrder() const;
+    void setSortOrder(SortOrder order);
     bool isAccepted(DataObject *item);
 
+    virtual QVariant data(const QModelIndex& index, int role) const;
+
 protected:
+    virtual void notifyBackingCollectionChanged();
+    virtual QHash<int, QByteArray> roleNames() const;
+
     virtual QVariant toVariant(DataObject* object) const;
     virtual DataObject* fromVariant(QVariant var) const;
+
+private:
+    void applySortOrder();
+
+    SortOrder m_sortOrder;
 };
 
 QML_DECLARE_TYPE(QmlMediaCollectionModel)
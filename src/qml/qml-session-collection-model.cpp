@@ -0,0 +1,283 @@
+/*
+ * Copyright (C) 2014 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "qml-session-collection-model.h"
+
+// core
+#include "data-object.h"
+
+// media
+#include "media-collection.h"
+#include "media-source.h"
+
+// src
+#include "gallery-manager.h"
+
+#include <QDateTime>
+
+#include <algorithm>
+
+// a break of more than three hours starts a new session by default
+static const int DEFAULT_GAP_MINUTES = 180;
+static const qint64 MSECS_PER_MINUTE = 60 * 1000;
+
+/*!
+ * \brief sessionLessThan orders sessions as the clusterer lists them
+ * \param a
+ * \param b
+ * \return
+ */
+static bool sessionLessThan(const SessionClusterer::Session& a, const SessionClusterer::Session& b)
+{
+    return (a.startMSecs != b.startMSecs) ? a.startMSecs < b.startMSecs
+                                          : a.startNumber < b.startNumber;
+}
+
+/*!
+ * \brief QmlSessionCollectionModel::QmlSessionCollectionModel
+ * \param parent
+ */
+QmlSessionCollectionModel::QmlSessionCollectionModel(QObject* parent)
+    : QAbstractListModel(parent),
+      m_clusterer(DEFAULT_GAP_MINUTES * MSECS_PER_MINUTE)
+{
+    MediaCollection* media = GalleryManager::instance()->mediaCollection();
+
+    QObject::connect(
+                media,
+                SIGNAL(contentsChanged(const QSet<DataObject*>*,const QSet<DataObject*>*, bool)),
+                this,
+                SLOT(onMediaAddedRemoved(const QSet<DataObject*>*,const QSet<DataObject*>*, bool)));
+    QObject::connect(media, SIGNAL(contentDataChanged(DataObject*)),
+                     this, SLOT(onMediaDataChanged(DataObject*)));
+
+    onMediaAddedRemoved(&media->getAsSet(), NULL, true);
+}
+
+/*!
+ * \brief QmlSessionCollectionModel::count
+ * \return
+ */
+int QmlSessionCollectionModel::count() const
+{
+    return m_sessions.count();
+}
+
+/*!
+ * \brief QmlSessionCollectionModel::gapMinutes
+ * \return the longest break between two media of the same session
+ */
+int QmlSessionCollectionModel::gapMinutes() const
+{
+    return m_clusterer.gap() / MSECS_PER_MINUTE;
+}
+
+/*!
+ * \brief QmlSessionCollectionModel::setGapMinutes
+ * \param minutes
+ */
+void QmlSessionCollectionModel::setGapMinutes(int minutes)
+{
+    if (minutes < 0 || minutes == gapMinutes())
+        return;
+
+    m_clusterer.setGap(minutes * MSECS_PER_MINUTE);
+    reset();
+
+    emit gapMinutesChanged();
+}
+
+/*!
+ * \brief QmlSessionCollectionModel::rowCount
+ * \param parent
+ * \return
+ */
+int QmlSessionCollectionModel::rowCount(const QModelIndex& parent) const
+{
+    Q_UNUSED(parent);
+
+    return count();
+}
+
+/*!
+ * \brief QmlSessionCollectionModel::data
+ * \param index
+ * \param role
+ * \return
+ */
+QVariant QmlSessionCollectionModel::data(const QModelIndex& index, int role) const
+{
+    if (index.row() < 0 || index.row() >= m_sessions.count())
+        return QVariant();
+
+    // the clusterer lists the sessions oldest first
+    const SessionClusterer::Session& session = m_sessions.at(m_sessions.count() - 1 - index.row());
+
+    switch (role) {
+    case StartDateTimeRole:
+        return QVariant(QDateTime::fromMSecsSinceEpoch(session.startMSecs));
+
+    case EndDateTimeRole:
+        return QVariant(QDateTime::fromMSecsSinceEpoch(session.endMSecs));
+
+    case MediaCountRole:
+        return QVariant(session.count);
+
+    default:
+        return QVariant();
+    }
+}
+
+/*!
+ * \brief QmlSessionCollectionModel::roleNames
+ * \return
+ */
+QHash<int, QByteArray> QmlSessionCollectionModel::roleNames() const
+{
+    QHash<int, QByteArray> roles;
+    roles.insert(StartDateTimeRole, "startDateTime");
+    roles.insert(EndDateTimeRole, "endDateTime");
+    roles.insert(MediaCountRole, "mediaCount");
+
+    return roles;
+}
+
+/*!
+ * \brief QmlSessionCollectionModel::onMediaAddedRemoved
+ * \param added
+ * \param removed
+ * \param notify
+ */
+void QmlSessionCollectionModel::onMediaAddedRemoved(const QSet<DataObject*>* added,
+                                                    const QSet<DataObject*>* removed,
+                                                    bool notify)
+{
+    Q_UNUSED(notify);
+
+    bool changed = false;
+    DataObject* object;
+
+    if (removed != NULL) {
+        foreach (object, *removed) {
+            MediaSource* media = qobject_cast<MediaSource*>(object);
+            if (media != NULL)
+                changed |= m_clusterer.remove(media);
+        }
+    }
+
+    if (added != NULL) {
+        foreach (object, *added) {
+            MediaSource* media = qobject_cast<MediaSource*>(object);
+            if (media != NULL)
+                changed |= m_clusterer.insert(media);
+        }
+    }
+
+    if (changed)
+        applyChanges();
+}
+
+/*!
+ * \brief QmlSessionCollectionModel::onMediaDataChanged
+ * \param object
+ */
+void QmlSessionCollectionModel::onMediaDataChanged(DataObject* object)
+{
+    MediaSource* media = qobject_cast<MediaSource*>(object);
+    if (media != NULL && m_clusterer.update(media))
+        applyChanges();
+}
+
+/*!
+ * \brief QmlSessionCollectionModel::applyChanges
+ * Removes, updates and inserts the rows of the sessions the clusterer has
+ * touched, so views keep the delegates of all the others
+ */
+void QmlSessionCollectionModel::applyChanges()
+{
+    // nothing to keep on the first load
+    if (m_sessions.isEmpty()) {
+        reset();
+        return;
+    }
+
+    SessionClusterer::Changes changes = m_clusterer.takeChanges();
+    int old_count = m_sessions.count();
+    SessionClusterer::Session session;
+
+    // rows run newest first, the other way round from m_sessions
+    foreach (session, changes.removed) {
+        int at = indexOf(session);
+        int row = m_sessions.count() - 1 - at;
+
+        beginRemoveRows(QModelIndex(), row, row);
+        m_sessions.removeAt(at);
+        endRemoveRows();
+    }
+
+    foreach (session, changes.changed) {
+        int at = indexOf(session);
+        m_sessions[at] = session;
+
+        QModelIndex row = index(m_sessions.count() - 1 - at);
+        emit dataChanged(row, row);
+    }
+
+    foreach (session, changes.added) {
+        int at = std::lower_bound(m_sessions.begin(), m_sessions.end(), session, sessionLessThan)
+                - m_sessions.begin();
+        int row = m_sessions.count() - at;
+
+        beginInsertRows(QModelIndex(), row, row);
+        m_sessions.insert(at, session);
+        endInsertRows();
+    }
+
+    if (m_sessions.count() != old_count)
+        emit countChanged();
+}
+
+/*!
+ * \brief QmlSessionCollectionModel::indexOf
+ * \param session
+ * \return the position in m_sessions of the session with the same start
+ */
+int QmlSessionCollectionModel::indexOf(const SessionClusterer::Session& session) const
+{
+    QList<SessionClusterer::Session>::const_iterator found =
+            std::lower_bound(m_sessions.constBegin(), m_sessions.constEnd(), session, sessionLessThan);
+    Q_ASSERT(found != m_sessions.constEnd() && found->startMSecs == session.startMSecs
+             && found->startNumber == session.startNumber);
+
+    return found - m_sessions.constBegin();
+}
+
+/*!
+ * \brief QmlSessionCollectionModel::reset
+ * Only the sessions are copied out, which are far fewer than the media
+ */
+void QmlSessionCollectionModel::reset()
+{
+    int old_count = m_sessions.count();
+
+    beginResetModel();
+    m_sessions = m_clusterer.sessions();
+    m_clusterer.takeChanges();
+    endResetModel();
+
+    if (m_sessions.count() != old_count)
+        emit countChanged();
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2014 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GALLERY_QML_SESSION_COLLECTION_MODEL_H_
+#define GALLERY_QML_SESSION_COLLECTION_MODEL_H_
+
+// event
+#include "session-clusterer.h"
+
+#include <QAbstractListModel>
+#include <QList>
+#include <QSet>
+#include <QtQml>
+
+class DataObject;
+
+/*!
+ * \brief The QmlSessionCollectionModel class lists the library's media grouped
+ * into sessions, newest first, rather than into one Event per day
+ */
+class QmlSessionCollectionModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+    Q_PROPERTY(int gapMinutes READ gapMinutes WRITE setGapMinutes
+               NOTIFY gapMinutesChanged)
+
+signals:
+    void countChanged();
+    void gapMinutesChanged();
+
+public:
+    enum SessionRole {
+        StartDateTimeRole = Qt::UserRole + 1,
+        EndDateTimeRole,
+        MediaCountRole
+    };
+
+    QmlSessionCollectionModel(QObject* parent = NULL);
+
+    int count() const;
+    int gapMinutes() const;
+    void setGapMinutes(int minutes);
+
+    virtual int rowCount(const QModelIndex& parent) const;
+    virtual QVariant data(const QModelIndex& index, int role) const;
+    virtual QHash<int, QByteArray> roleNames() const;
+
+private slots:
+    void onMediaAddedRemoved(const QSet<DataObject*>* added,
+                             const QSet<DataObject*>* removed,
+                             bool notify);
+    void onMediaDataChanged(DataObject* object);
+
+private:
+    void applyChanges();
+    int indexOf(const SessionClusterer::Session& session) const;
+    void reset();
+
+    SessionClusterer m_clusterer;
+    QList<SessionClusterer::Session> m_sessions;
+};
+
+QML_DECLARE_TYPE(QmlSessionCollectionModel)
+
+#endif  // GALLERY_QML_SESSION_COLLECTION_MODEL_H_
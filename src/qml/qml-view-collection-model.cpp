@@ -23,10 +23,25 @@
 #include "container-source.h"
 #include "data-object.h"
 #include "selectable-view-collection.h"
+#include "view-window.h"
 
 // util
 #include "variants.h"
 
+/*!
+ * \brief rangesCount
+ * \param ranges
+ * \return the number of indexes the ranges cover
+ */
+static int rangesCount(const QList<DataIndexRange>& ranges)
+{
+    int count = 0;
+    foreach (const DataIndexRange& range, ranges)
+        count += range.second - range.first + 1;
+
+    return count;
+}
+
 /*!
  * \brief QmlViewCollectionModel::QmlViewCollectionModel
  * \param parent
@@ -238,28 +253,18 @@ bool QmlViewCollectionModel::isSelected(const QVariant &var) const
 }
 
 /*!
- * \brief QmlViewCollectionModel::rowCount
- * \param parent
- * \return
- */
-int QmlViewCollectionModel::rowCount(const QModelIndex& parent) const
-{
-    return count();
-}
-
-/*!
- * \brief QmlViewCollectionModel::data
+ * \brief QmlViewCollectionModel::viewIndex
  * \param index
- * \param role
- * \return
+ * \return the index in the backing collection of a row, or -1 if the row is
+ * outside the head and limit
  */
-QVariant QmlViewCollectionModel::data(const QModelIndex& index, int role) const
+int QmlViewCollectionModel::viewIndex(const QModelIndex& index) const
 {
     if (m_view == NULL)
-        return QVariant();
+        return -1;
 
     if (m_limit == 0)
-        return QVariant();
+        return -1;
 
     // calculate actual starting index from the head (a negative head means to
     // start from n elements from the tail of the list; relying on negative value
@@ -269,10 +274,35 @@ QVariant QmlViewCollectionModel::data(const QModelIndex& index, int role) const
 
     // bounds checking
     if (real_index < 0 || real_index >= m_view->count())
-        return QVariant();
+        return -1;
 
     // watch for indexing beyond upper limit
     if (m_limit > 0 && real_index >= (real_start + m_limit))
+        return -1;
+
+    return real_index;
+}
+
+/*!
+ * \brief QmlViewCollectionModel::rowCount
+ * \param parent
+ * \return
+ */
+int QmlViewCollectionModel::rowCount(const QModelIndex& parent) const
+{
+    return count();
+}
+
+/*!
+ * \brief QmlViewCollectionModel::data
+ * \param index
+ * \param role
+ * \return
+ */
+QVariant QmlViewCollectionModel::data(const QModelIndex& index, int role) const
+{
+    int real_index = viewIndex(index);
+    if (real_index < 0)
         return QVariant();
 
     DataObject* object = m_view->getAt(real_index);
@@ -285,11 +315,20 @@ QVariant QmlViewCollectionModel::data(const QModelIndex& index, int role) const
         return toVariant(object);
 
     case SelectionRole:
-        return QVariant(m_view->isSelected(object));
+        return QVariant(m_view->isSelectedAt(real_index));
+
+    case TypeNameRole: {
+        QHash<const QMetaObject*, QVariant>::const_iterator type_name =
+                m_typeNames.constFind(object->metaObject());
+        if (type_name != m_typeNames.constEnd())
+            return type_name.value();
 
-    case TypeNameRole:
         // Return type name with the pointer ("*") removed
-        return QVariant(QString(toVariant(object).typeName()).remove('*'));
+        QVariant name(QString(toVariant(object).typeName()).remove('*'));
+        m_typeNames.insert(object->metaObject(), name);
+
+        return name;
+    }
 
     default:
         return QVariant();
@@ -354,12 +393,13 @@ void QmlViewCollectionModel::setHead(int head) {
     if (m_head == head)
         return;
 
+    int old_head = m_head;
     m_head = head;
 
+    notifyWindowMoved(old_head, m_limit);
+
     emit headChanged();
-    // TODO: this could be checked for and optimized instead of nuking it all.
     emit countChanged();
-    notifyReset();
 }
 
 /*!
@@ -382,11 +422,13 @@ void QmlViewCollectionModel::setLimit(int limit)
     if (m_limit == normalized)
         return;
 
+    int old_limit = m_limit;
     m_limit = normalized;
 
+    notifyWindowMoved(m_head, old_limit);
+
     emit limitChanged();
     emit countChanged();
-    notifyReset();
 }
 
 /*!
@@ -443,19 +485,17 @@ void QmlViewCollectionModel::setBackingViewCollection(SelectableViewCollection*
     endResetModel();
 
     QObject::connect(m_view,
-                     SIGNAL(selectionChanged(const QSet<DataObject*>*, const QSet<DataObject*>*)),
+                     SIGNAL(selectionRangesChanged(const QList<DataIndexRange>*, bool)),
                      this,
-                     SLOT(onSelectionChanged(const QSet<DataObject*>*, const QSet<DataObject*>*)));
+                     SLOT(onSelectionRangesChanged(const QList<DataIndexRange>*, bool)));
 
     QObject::connect(m_view,
-                     SIGNAL(contentsAboutToBeChanged(const QSet<DataObject*>*, const QSet<DataObject*>*)),
+                     SIGNAL(contentsRangesChanged(const DataCollectionDelta*, bool)),
                      this,
-                     SLOT(onContentsAboutToBeChanged(const QSet<DataObject*>*, const QSet<DataObject*>*)));
+                     SLOT(onContentsRangesChanged(const DataCollectionDelta*, bool)));
 
-    QObject::connect(m_view,
-                     SIGNAL(contentsChanged(const QSet<DataObject*>*, const QSet<DataObject*>*, bool)),
-                     this,
-                     SLOT(onContentsChanged(const QSet<DataObject*>*, const QSet<DataObject*>*, bool)));
+    QObject::connect(m_view, SIGNAL(contentDataChanged(DataObject*)),
+                     this, SLOT(onContentDataChanged(DataObject*)));
 
     QObject::connect(m_view, SIGNAL(orderingChanged()),
                      this, SLOT(onOrderingChanged()));
@@ -482,19 +522,17 @@ void QmlViewCollectionModel::disconnectBackingViewCollection()
         return;
 
     QObject::disconnect(m_view,
-                        SIGNAL(selectionChanged(const QSet<DataObject*>*, const QSet<DataObject*>*)),
+                        SIGNAL(selectionRangesChanged(const QList<DataIndexRange>*, bool)),
                         this,
-                        SLOT(onSelectionChanged(const QSet<DataObject*>*, const QSet<DataObject*>*)));
+                        SLOT(onSelectionRangesChanged(const QList<DataIndexRange>*, bool)));
 
     QObject::disconnect(m_view,
-                        SIGNAL(contentsAboutToBeChanged(const QSet<DataObject*>*, const QSet<DataObject*>*)),
+                        SIGNAL(contentsRangesChanged(const DataCollectionDelta*, bool)),
                         this,
-                        SLOT(onContentsAboutToBeChanged(const QSet<DataObject*>*, const QSet<DataObject*>*)));
+                        SLOT(onContentsRangesChanged(const DataCollectionDelta*, bool)));
 
-    QObject::disconnect(m_view,
-                        SIGNAL(contentsChanged(const QSet<DataObject*>*, const QSet<DataObject*>*, bool)),
-                        this,
-                        SLOT(onContentsChanged(const QSet<DataObject*>*, const QSet<DataObject*>*, bool)));
+    QObject::disconnect(m_view, SIGNAL(contentDataChanged(DataObject*)),
+                        this, SLOT(onContentDataChanged(DataObject*)));
 
     QObject::disconnect(m_view, SIGNAL(orderingChanged()),
                         this, SLOT(onOrderingChanged()));
@@ -584,19 +622,12 @@ MediaSource::MediaType QmlViewCollectionModel::mediaTypeFilter() const
 void QmlViewCollectionModel::setMediaTypeFilter(MediaSource::MediaType mediaTypeFilter)
 {
     if (m_mediaTypeFilter != mediaTypeFilter) {
-        const DataCollection* collection = 0;
-        QString viewName;
-
-        if (m_view) {
-            collection = m_view->collection();
-            viewName = m_view->toString();
-            disconnectBackingViewCollection();
-        }
-
         m_mediaTypeFilter = mediaTypeFilter;
-        if (collection) {
-            monitorCollection(collection, viewName);
-        }
+
+        // only what moves in or out of the filter is touched; the view and
+        // whatever remains selected in it are kept
+        if (m_view != NULL)
+            m_view->refilter();
 
         Q_EMIT mediaTypeFilterChanged();
     }
@@ -660,16 +691,17 @@ void QmlViewCollectionModel::notifyElementsAdded(int first, int last)
 }
 
 /*!
- * \brief QmlViewCollectionModel::notifyElementRemoved
- * This notifies model subscribers that the element at this index was
- * removed ... note that QmlViewCollectionModel monitors the
+ * \brief QmlViewCollectionModel::notifyElementsRemoved
+ * This notifies model subscribers that the elements between these indexes
+ * were removed ... note that QmlViewCollectionModel monitors the
  * SelectableViewCollections' "contents-altered" signal already
- * \param index
+ * \param first
+ * \param last
  */
-void QmlViewCollectionModel::notifyElementRemoved(int index)
+void QmlViewCollectionModel::notifyElementsRemoved(int first, int last)
 {
-    if (index >= 0) {
-        beginRemoveRows(QModelIndex(), index, index);
+    if (first >= 0 && last >= 0) {
+        beginRemoveRows(QModelIndex(), first, last);
         endRemoveRows();
     }
 }
@@ -690,15 +722,60 @@ void QmlViewCollectionModel::notifyElementChanged(int index, int role)
 }
 
 /*!
- * \brief QmlViewCollectionModel::notifySetChanged
- * \param list
- * \param role
+ * \brief QmlViewCollectionModel::notifyElementsChanged
+ * This notifies model subscribers that the elements between these indexes of
+ * the backing collection have been altered, clipped to the rows within the
+ * head and limit
+ * \param first
+ * \param last
+ * \param roles the roles that changed, or empty for all of them
  */
-void QmlViewCollectionModel::notifySetChanged(const QSet<DataObject*>* list, int role)
+void QmlViewCollectionModel::notifyElementsChanged(int first, int last, const QVector<int>& roles)
 {
-    DataObject* object;
-    foreach (object, *list)
-        notifyElementChanged(m_view->indexOf(object), role);
+    int real_start = (m_head >= 0) ? m_head : m_view->count() + m_head;
+
+    first = qMax(first - real_start, 0);
+    last = qMin(last - real_start, count() - 1);
+    if (first > last)
+        return;
+
+    emit dataChanged(createIndex(first, 0), createIndex(last, 0), roles);
+}
+
+/*!
+ * \brief QmlViewCollectionModel::notifyWindowMoved
+ * Tells model subscribers which rows left and joined the head/limit window
+ * after it was moved or resized over the same elements
+ * \param oldHead
+ * \param oldLimit
+ */
+void QmlViewCollectionModel::notifyWindowMoved(int oldHead, int oldLimit)
+{
+    if (m_view == NULL)
+        return;
+
+    if (oldHead < 0 || m_head < 0) {
+        notifyReset();
+
+        return;
+    }
+
+    notifyWindowChanged(ViewWindow::moved(m_view->count(), oldHead, oldLimit, m_head, m_limit));
+}
+
+/*!
+ * \brief QmlViewCollectionModel::notifyWindowChanged
+ * Reports the rows that left the head/limit window as removed, then the
+ * rows that joined it as added
+ * \param change
+ */
+void QmlViewCollectionModel::notifyWindowChanged(const ViewWindowChange& change)
+{
+    foreach (const DataIndexRange& range, change.removedRows)
+        notifyElementsRemoved(range.first, range.second);
+
+    foreach (const DataIndexRange& range, change.addedRows)
+        notifyElementsAdded(range.first, range.second);
 }
 
 /*!
@@ -720,126 +797,90 @@ QHash<int, QByteArray> QmlViewCollectionModel::roleNames() const
 }
 
 /*!
- * \brief QmlViewCollectionModel::onSelectionChanged
+ * \brief QmlViewCollectionModel::onSelectionRangesChanged
+ * \param ranges
  * \param selected
- * \param unselected
  */
-void QmlViewCollectionModel::onSelectionChanged(const QSet<DataObject*>* selected,
-                                                  const QSet<DataObject*>* unselected)
+void QmlViewCollectionModel::onSelectionRangesChanged(const QList<DataIndexRange>* ranges,
+                                                      bool selected)
 {
-    if (selected != NULL)
-        notifySetChanged(selected, SelectionRole);
+    Q_UNUSED(selected);
 
-    if (unselected != NULL)
-        notifySetChanged(unselected, SelectionRole);
+    DataIndexRange range;
+    foreach (range, *ranges)
+        notifyElementsChanged(range.first, range.second, QVector<int>() << SelectionRole);
 
     emit selectionChanged();
     emit selectedCountChanged();
 }
 
 /*!
- * \brief QmlViewCollectionModel::onContentsAboutToBeChanged
- * \param added
- * \param removed
+ * \brief QmlViewCollectionModel::onContentDataChanged
+ * \param object
  */
-void QmlViewCollectionModel::onContentsAboutToBeChanged(const QSet<DataObject*>* added,
-                                                       const QSet<DataObject*>* removed)
+void QmlViewCollectionModel::onContentDataChanged(DataObject* object)
 {
-    // Gather the indexes of all the elements to be removed before removal,
-    // then report their removal when they've actually been removed
-    if (removed != NULL) {
-        // should already be cleared; either first use or cleared in on_contents_altered()
-        Q_ASSERT(m_toBeRemoved.count() == 0);
-        DataObject* object;
-        foreach (object, *removed) {
-            int index = m_view->indexOf(object);
-            Q_ASSERT(index >= 0);
-            m_toBeRemoved.append(index);
-        }
-    }
+    int index = m_view->indexOf(object);
+    if (index >= 0)
+        notifyElementsChanged(index, index);
 }
 
 /*!
- * \brief QmlViewCollectionModel::onContentsChanged
- * \param added
- * \param removed
+ * \brief QmlViewCollectionModel::onContentsRangesChanged
+ * The view describes each change as runs of removed and inserted indexes, so
+ * they map straight onto row ranges without looking up or sorting each index
+ * \param delta
+ * \param notify
  */
-void QmlViewCollectionModel::onContentsChanged(const QSet<DataObject*>* added,
-                                                 const QSet<DataObject*>* removed,
-                                                 bool notify)
+void QmlViewCollectionModel::onContentsRangesChanged(const DataCollectionDelta* delta,
+                                                     bool notify)
 {
-    // Report removed items using indices gathered from on_contents_to_be_altered()
-    if (m_toBeRemoved.count() > 0) {
-        if (notify) {
-            // sort indices in reverse order and walk in descending order so they're
-            // always accurate as items are "removed"
-            qSort(m_toBeRemoved.begin(), m_toBeRemoved.end(), intReverseLessThan);
-
-            // Only if we aren't getting a sub-view do we directly map these up to QML.
-            if (m_head == 0 && m_limit < 0) {
-                int index;
-                foreach (index, m_toBeRemoved)
-                    notifyElementRemoved(index);
-            }
+    bool windowed = (m_head != 0 || m_limit >= 0);
 
-            m_toBeRemoved.clear();
-        } else {
-            //FIXME We are doing a notifyReset since we are facing model corruption after
-            // some deletes on the Events tab
-            m_toBeRemoved.clear();
-            notifyReset();
+    if (!delta->removed.isEmpty() && !notify) {
+        //FIXME We are doing a notifyReset since we are facing model corruption after
+        // some deletes on the Events tab
+        notifyReset();
+    } else if (m_head < 0) {
+        // a negative head counts back from the tail, which every change moves
+        notifyReset();
+    } else if (windowed) {
+        // Replay the change one range at a time, working out which rows drop
+        // out of or slide into the head/limit window each time
+        int count = m_view->count() + rangesCount(delta->removed)
+                - rangesCount(delta->inserted);
+
+        DataIndexRange range;
+        foreach (range, delta->removed) {
+            notifyWindowChanged(ViewWindow::rangeRemoved(count, m_head, m_limit,
+                                                         range.first, range.second));
+            count -= range.second - range.first + 1;
         }
-    }
-
-    // Report inserted items after they've been inserted
-    // Again, don't map directly to QML if we're only getting a sub-view.
-    if (added != NULL && m_head == 0 && m_limit < 0) {
-        // sort the indices in ascending order so each element is added in the
-        // right place inside the "virtual" list held by QAbstractListModel
-        QList<int> indices;
 
-        DataObject* object;
-        foreach (object, *added) {
-            indices.append(m_view->indexOf(object));
+        foreach (range, delta->inserted) {
+            notifyWindowChanged(ViewWindow::rangeInserted(count, m_head, m_limit,
+                                                          range.first, range.second));
+            count += range.second - range.first + 1;
         }
-
-        qSort(indices.begin(), indices.end(), intLessThan);
-
-        if (!indices.isEmpty()) {
-            int index;
-            int head = -1;
-            int tail = -1;
-
-            // Notify each contiguos interval of indices
-            foreach (index, indices) {
-                if (head < 0) {
-                    head = index;
-                    tail = index;
-                } else {
-                    if (index == tail + 1) {
-                        tail = index;
-                    } else {
-                        notifyElementsAdded(head, tail);
-                        head = index;
-                        tail = index;
-                    }
-                }
-            }
-
-            notifyElementsAdded(head, tail);
-
-            foreach (index, indices) {
-                Q_EMIT(indexAdded(index));
+    } else {
+        // Removed ranges arrive in descending order so the earlier ones are
+        // still accurate as the later ones are "removed"
+        DataIndexRange range;
+        foreach (range, delta->removed)
+            notifyElementsRemoved(range.first, range.second);
+
+        foreach (range, delta->inserted)
+            notifyElementsAdded(range.first, range.second);
+
+        // a moved object isn't new to the model
+        if (!delta->moved) {
+            foreach (range, delta->inserted) {
+                for (int index = range.first; index <= range.second; ++index)
+                    Q_EMIT(indexAdded(index));
             }
         }
     }
 
-    // TODO: "filtered" views get some special treatment.  Instead of figuring
-    // out how each addition/deletion affects it, we just wipe the whole thing
-    // out each time it's altered.  This is probably wasteful.
-    if (m_head != 0 || m_limit >= 0)
-        notifyReset();
-
     emit rawCountChanged();
     emit countChanged();
 }
@@ -853,25 +894,3 @@ void QmlViewCollectionModel::onOrderingChanged()
 
     emit orderingChanged();
 }
-
-/*!
- * \brief QmlViewCollectionModel::intLessThan
- * \param a
- * \param b
- * \return
- */
-bool QmlViewCollectionModel::intLessThan(int a, int b)
-{
-    return a < b;
-}
-
-/*!
- * \brief QmlViewCollectionModel::intReverseLessThan
- * \param a
- * \param b
- * \return
- */
-bool QmlViewCollectionModel::intReverseLessThan(int a, int b)
-{
-    return b < a;
-}
@@ -37,6 +37,7 @@ class DataObject;
 class ContainerSource;
 class SelectableViewCollection;
 class SourceCollection;
+struct ViewWindowChange;
 
 /*!
  * \brief The QmlViewCollectionModel class
@@ -147,39 +148,37 @@ protected:
     virtual DataObject* fromVariant(QVariant var) const = 0;
 
     void notifyElementsAdded(int first, int last);
-    void notifyElementRemoved(int index);
+    void notifyElementsRemoved(int first, int last);
     void notifyElementChanged(int index, int role);
+    void notifyElementsChanged(int first, int last, const QVector<int>& roles = QVector<int>());
+    int viewIndex(const QModelIndex& index) const;
     void notifyReset();
 
     virtual QHash<int, QByteArray> roleNames() const;
 
 private slots:
-    void onSelectionChanged(const QSet<DataObject*>* selected,
-                            const QSet<DataObject*>* unselected);
-    void onContentsAboutToBeChanged(const QSet<DataObject*>* added,
-                                    const QSet<DataObject*>* removed);
-    void onContentsChanged(const QSet<DataObject*>* add,
-                             const QSet<DataObject*>* removed,
-                             bool notify);
+    void onSelectionRangesChanged(const QList<DataIndexRange>* ranges, bool selected);
+    void onContentDataChanged(DataObject* object);
+    void onContentsRangesChanged(const DataCollectionDelta* delta, bool notify);
     void onOrderingChanged();
 
 private:
     QVariant m_collection;
     QVariant m_monitorSelection;
     SelectableViewCollection* m_view;
-    QList<int> m_toBeRemoved;
     DataObjectComparator m_defaultComparator;
     int m_head;
     int m_limit;
     QHash<int, QByteArray> m_roles;
+    // TypeNameRole depends only on the object's class
+    mutable QHash<const QMetaObject*, QVariant> m_typeNames;
     MediaSource::MediaType m_mediaTypeFilter;
 
-    static bool intLessThan(int a, int b);
-    static bool intReverseLessThan(int a, int b);
+    void notifyWindowMoved(int oldHead, int oldLimit);
+    void notifyWindowChanged(const ViewWindowChange& change);
 
     void setBackingViewCollection(SelectableViewCollection* view);
     void disconnectBackingViewCollection();
-    void notifySetChanged(const QSet<DataObject*> *list, int role);
 };
 
 #endif  // GALLERY_QML_VIEW_COLLECTION_MODEL_H_
@@ -0,0 +1,337 @@
+/*
+ * Copyright (C) 2014 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "bit-set.h"
+
+#include <QtAlgorithms>
+
+static const int WORD_BITS = 64;
+
+/*!
+ * \brief wordCount
+ * \param size
+ * \return the number of words needed to hold size bits
+ */
+static inline int wordCount(int size)
+{
+    return (size + WORD_BITS - 1) / WORD_BITS;
+}
+
+/*!
+ * \brief lowMask
+ * \param bits
+ * \return a word with the lowest bits set
+ */
+static inline quint64 lowMask(int bits)
+{
+    return (bits >= WORD_BITS) ? ~Q_UINT64_C(0) : ((Q_UINT64_C(1) << bits) - 1);
+}
+
+/*!
+ * \brief readBits
+ * \param words
+ * \param from
+ * \param bits no more than a word's worth
+ * \return the bits starting at from, in the low end of the word
+ */
+static inline quint64 readBits(const quint64* words, int from, int bits)
+{
+    int word = from / WORD_BITS;
+    int shift = from % WORD_BITS;
+
+    quint64 value = words[word] >> shift;
+    if (shift != 0 && shift + bits > WORD_BITS)
+        value |= words[word + 1] << (WORD_BITS - shift);
+
+    return value & lowMask(bits);
+}
+
+/*!
+ * \brief copyBits
+ * Copies a run of bits a word at a time into a destination whose bits are
+ * still clear
+ * \param from
+ * \param fromIndex
+ * \param to
+ * \param toIndex
+ * \param bits
+ */
+static void copyBits(const quint64* from, int fromIndex, quint64* to, int toIndex, int bits)
+{
+    while (bits > 0) {
+        int chunk = qMin(bits, WORD_BITS - (toIndex % WORD_BITS));
+        to[toIndex / WORD_BITS] |= readBits(from, fromIndex, chunk) << (toIndex % WORD_BITS);
+
+        fromIndex += chunk;
+        toIndex += chunk;
+        bits -= chunk;
+    }
+}
+
+/*!
+ * \brief BitSet::BitSet
+ */
+BitSet::BitSet()
+    : m_size(0), m_count(0)
+{
+}
+
+/*!
+ * \brief BitSet::size
+ * \return
+ */
+int BitSet::size() const
+{
+    return m_size;
+}
+
+/*!
+ * \brief BitSet::count
+ * \return the number of bits set
+ */
+int BitSet::count() const
+{
+    return m_count;
+}
+
+/*!
+ * \brief BitSet::count
+ * \param first
+ * \param last
+ * \return the number of bits set between first and last
+ */
+int BitSet::count(int first, int last) const
+{
+    Q_ASSERT(first >= 0 && last < m_size);
+
+    int count = 0;
+    for (int word = first / WORD_BITS; word <= last / WORD_BITS && first <= last; ++word) {
+        int low = (word == first / WORD_BITS) ? first % WORD_BITS : 0;
+        int high = (word == last / WORD_BITS) ? last % WORD_BITS : WORD_BITS - 1;
+
+        count += qPopulationCount(m_words[word] & (lowMask(high - low + 1) << low));
+    }
+
+    return count;
+}
+
+/*!
+ * \brief BitSet::resize
+ * Bits added at the end are clear
+ * \param size
+ */
+void BitSet::resize(int size)
+{
+    Q_ASSERT(size >= 0);
+
+    m_words.resize(wordCount(size));
+    m_size = size;
+
+    // keep the bits past the end clear, so whole words can be counted and
+    // copied without masking
+    if (m_size % WORD_BITS != 0)
+        m_words[m_words.count() - 1] &= lowMask(m_size % WORD_BITS);
+
+    recount();
+}
+
+/*!
+ * \brief BitSet::clear
+ */
+void BitSet::clear()
+{
+    m_words.clear();
+    m_size = 0;
+    m_count = 0;
+}
+
+/*!
+ * \brief BitSet::testBit
+ * \param index
+ * \return
+ */
+bool BitSet::testBit(int index) const
+{
+    Q_ASSERT(index >= 0 && index < m_size);
+
+    return (m_words[index / WORD_BITS] >> (index % WORD_BITS)) & 1;
+}
+
+/*!
+ * \brief BitSet::setBit
+ * \param index
+ * \param value
+ * \return true if the bit changed
+ */
+bool BitSet::setBit(int index, bool value)
+{
+    return setRange(index, index, value) != 0;
+}
+
+/*!
+ * \brief BitSet::setRange
+ * Sets or clears a run of bits a word at a time
+ * \param first
+ * \param last
+ * \param value
+ * \return the number of bits that changed
+ */
+int BitSet::setRange(int first, int last, bool value)
+{
+    Q_ASSERT(first >= 0 && last < m_size);
+
+    int changed = 0;
+    for (int word = first / WORD_BITS; word <= last / WORD_BITS; ++word) {
+        int low = (word == first / WORD_BITS) ? first % WORD_BITS : 0;
+        int high = (word == last / WORD_BITS) ? last % WORD_BITS : WORD_BITS - 1;
+        quint64 mask = lowMask(high - low + 1) << low;
+
+        quint64 before = m_words[word];
+        m_words[word] = value ? (before | mask) : (before & ~mask);
+        changed += qPopulationCount(before ^ m_words[word]);
+    }
+
+    m_count += value ? changed : -changed;
+
+    return changed;
+}
+
+/*!
+ * \brief BitSet::runs
+ * \param first
+ * \param last
+ * \param value
+ * \return the runs of bits between first and last that are set (or clear),
+ * in ascending order
+ */
+QList<BitSet::Range> BitSet::runs(int first, int last, bool value) const
+{
+    QList<Range> runs;
+
+    int start = nextBit(first, last, value);
+    while (start <= last) {
+        int end = nextBit(start, last, !value) - 1;
+        runs.append(Range(start, end));
+
+        start = nextBit(end + 1, last, value);
+    }
+
+    return runs;
+}
+
+/*!
+ * \brief BitSet::insertRanges
+ * Opens up clear bits at the given positions, moving the bits after them up
+ * \param ranges in ascending order, as positions after the insertion
+ */
+void BitSet::insertRanges(const QList<Range>& ranges)
+{
+    if (ranges.isEmpty())
+        return;
+
+    int inserted = 0;
+    foreach (const Range& range, ranges)
+        inserted += range.second - range.first + 1;
+
+    QVector<quint64> words(wordCount(m_size + inserted), 0);
+
+    int from = 0;
+    int to = 0;
+    foreach (const Range& range, ranges) {
+        copyBits(m_words.constData(), from, words.data(), to, range.first - to);
+        from += range.first - to;
+        to = range.second + 1;
+    }
+    copyBits(m_words.constData(), from, words.data(), to, m_size - from);
+
+    m_words = words;
+    m_size += inserted;
+}
+
+/*!
+ * \brief BitSet::removeRanges
+ * Closes up the given positions, moving the bits after them down
+ * \param ranges non-overlapping, in any order
+ */
+void BitSet::removeRanges(const QList<Range>& ranges)
+{
+    if (ranges.isEmpty())
+        return;
+
+    QList<Range> ascending(ranges);
+    qSort(ascending.begin(), ascending.end());
+
+    int removed = 0;
+    foreach (const Range& range, ascending)
+        removed += range.second - range.first + 1;
+
+    QVector<quint64> words(wordCount(m_size - removed), 0);
+
+    int from = 0;
+    int to = 0;
+    foreach (const Range& range, ascending) {
+        copyBits(m_words.constData(), from, words.data(), to, range.first - from);
+        to += range.first - from;
+        from = range.second + 1;
+    }
+    copyBits(m_words.constData(), from, words.data(), to, m_size - from);
+
+    m_words = words;
+    m_size -= removed;
+
+    recount();
+}
+
+/*!
+ * \brief BitSet::nextBit
+ * Skips whole words that can't hold a match
+ * \param from
+ * \param last
+ * \param value
+ * \return the first position from onwards whose bit is value, or last + 1 if
+ * there is none up to last
+ */
+int BitSet::nextBit(int from, int last, bool value) const
+{
+    if (from > last)
+        return last + 1;
+
+    int word = from / WORD_BITS;
+    quint64 bits = (value ? m_words[word] : ~m_words[word]) & ~lowMask(from % WORD_BITS);
+
+    for (;;) {
+        if (bits != 0) {
+            int index = word * WORD_BITS + qCountTrailingZeroBits(bits);
+
+            return qMin(index, last + 1);
+        }
+
+        if (++word > last / WORD_BITS)
+            return last + 1;
+
+        bits = value ? m_words[word] : ~m_words[word];
+    }
+}
+
+/*!
+ * \brief BitSet::recount
+ */
+void BitSet::recount()
+{
+    m_count = 0;
+    for (int word = 0; word < m_words.count(); ++word)
+        m_count += qPopulationCount(m_words[word]);
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2014 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GALLERY_UTIL_BIT_SET_H_
+#define GALLERY_UTIL_BIT_SET_H_
+
+#include <QList>
+#include <QPair>
+#include <QVector>
+
+/**
+  * A dense set of bits addressed by position, packed 64 to a word.  Unlike
+  * QBitArray it can open up and close runs of positions in the middle, so it
+  * can stay aligned with a list that has items inserted and removed, and it
+  * keeps a running count of the bits set.  Ranges are first and last
+  * inclusive.
+  */
+class BitSet
+{
+public:
+    typedef QPair<int, int> Range;
+
+    BitSet();
+
+    int size() const;
+    int count() const;
+    int count(int first, int last) const;
+
+    void resize(int size);
+    void clear();
+
+    bool testBit(int index) const;
+    bool setBit(int index, bool value);
+    int setRange(int first, int last, bool value);
+
+    QList<Range> runs(int first, int last, bool value) const;
+
+    void insertRanges(const QList<Range>& ranges);
+    void removeRanges(const QList<Range>& ranges);
+
+private:
+    int nextBit(int from, int last, bool value) const;
+    void recount();
+
+    QVector<quint64> m_words;
+    int m_size;
+    int m_count;
+};
+
+#endif  // GALLERY_UTIL_BIT_SET_H_
@@ -19,10 +19,337 @@
 
 
 #include <QApplication>
+#include <QDebug>
+#include <QImageReader>
+#include <QThread>
+#include <QVector>
+#include <QtConcurrentMap>
 #include <qmath.h>
 
 #include "imaging.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif (defined(__ARM_NEON__) || defined(__ARM_NEON)) && Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+#include <arm_neon.h>
+#define GALLERY_IMAGING_NEON
+#endif
+
+// Below this many pixels an image isn't worth splitting across threads
+static const int PARALLEL_IMAGE_THRESHOLD = 512 * 1024;
+
+/*!
+ * \brief bandHeight
+ * \param image
+ * \return how many scanlines to give each thread working on the image
+ */
+static int bandHeight(const QImage& image)
+{
+    int threads = QThread::idealThreadCount();
+    if (image.width() * image.height() < PARALLEL_IMAGE_THRESHOLD || threads < 2)
+        threads = 1;
+
+    return qMax(1, (image.height() + threads - 1) / threads);
+}
+
+/*!
+ * \brief bandCount
+ * \param image
+ * \return how many bands forEachBand() splits the image into
+ */
+static int bandCount(const QImage& image)
+{
+    int band_height = bandHeight(image);
+
+    return (image.height() + band_height - 1) / band_height;
+}
+
+/*!
+ * \brief The ScanlineBand struct
+ * A run of scanlines worked through on one thread
+ */
+struct ScanlineBand
+{
+    int index;
+    int firstLine;
+    int lastLine;
+};
+
+/*!
+ * \brief forEachBand
+ * Splits the image into bands of scanlines, one per core for large images,
+ * and runs the kernel on each, on worker threads when there are several.  A
+ * kernel writing to the image needs it detached up front, so the bands all
+ * write into the same pixels.
+ * \param image
+ * \param kernel called with each ScanlineBand
+ */
+template <typename Kernel>
+static void forEachBand(const QImage& image, const Kernel& kernel)
+{
+    int height = image.height();
+    int band_height = bandHeight(image);
+
+    QVector<ScanlineBand> bands;
+    for (int first = 0; first < height; first += band_height) {
+        ScanlineBand band = { bands.count(), first, qMin(first + band_height, height) - 1 };
+        bands.append(band);
+    }
+
+    if (bands.count() > 1)
+        QtConcurrent::blockingMap(bands, kernel);
+    else if (bands.count() == 1)
+        kernel(bands[0]);
+}
+
+/*!
+ * \brief The BandCounts struct
+ * The histogram of one band
+ */
+struct BandCounts
+{
+    int counts[256];
+};
+
+/*!
+ * \brief countPixels adds the value (the largest of red, green and blue) of
+ * each 32-bit pixel to the counts
+ * \param pixels
+ * \param count
+ * \param counts
+ */
+static void countPixels(const QRgb* pixels, int count, int* counts)
+{
+    int i = 0;
+
+#if defined(__SSE2__)
+    // four pixels at a time: the byte-wise maximum of the pixel shifted by
+    // none, one and two bytes leaves max(R, G, B) in the lowest byte
+    const __m128i low_byte = _mm_set1_epi32(0xff);
+    quint32 values[4];
+    for (; i + 4 <= count; i += 4) {
+        __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + i));
+        __m128i value = _mm_max_epu8(px, _mm_srli_epi32(px, 8));
+        value = _mm_and_si128(_mm_max_epu8(value, _mm_srli_epi32(px, 16)), low_byte);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(values), value);
+
+        counts[values[0]]++;
+        counts[values[1]]++;
+        counts[values[2]]++;
+        counts[values[3]]++;
+    }
+#elif defined(GALLERY_IMAGING_NEON)
+    // eight pixels at a time, split into their blue, green, red and alpha
+    // bytes
+    quint8 values[8];
+    for (; i + 8 <= count; i += 8) {
+        uint8x8x4_t px = vld4_u8(reinterpret_cast<const quint8*>(pixels + i));
+        vst1_u8(values, vmax_u8(vmax_u8(px.val[0], px.val[1]), px.val[2]));
+
+        for (int k = 0; k < 8; k++)
+            counts[values[k]]++;
+    }
+#endif
+
+    for (; i < count; i++) {
+        QRgb px = pixels[i];
+        counts[qMax(qMax(qRed(px), qGreen(px)), qBlue(px))]++;
+    }
+}
+
+/*!
+ * \brief The CountKernel struct
+ * Counts each band into its own histogram
+ */
+struct CountKernel
+{
+    const QImage* image;
+    BandCounts* bandCounts;
+
+    void operator()(const ScanlineBand& band) const
+    {
+        int* counts = bandCounts[band.index].counts;
+        for (int i = 0; i < 256; i++)
+            counts[i] = 0;
+
+        int width = image->width();
+        for (int j = band.firstLine; j <= band.lastLine; j++)
+            countPixels(reinterpret_cast<const QRgb*>(image->constScanLine(j)), width, counts);
+    }
+};
+
+/*!
+ * \brief enhancePixel
+ * Remaps the pixel's HSV value and saturation, keeping its hue.  Every
+ * channel keeps its place between the smallest and the largest, so only
+ * where those two land needs working out.
+ * \param px
+ * \param valueTable
+ * \param saturationTable
+ * \return
+ */
+static inline QRgb enhancePixel(QRgb px, const int* valueTable, const int* saturationTable)
+{
+    int r = qRed(px);
+    int g = qGreen(px);
+    int b = qBlue(px);
+    int max = qMax(qMax(r, g), b);
+    int min = qMin(qMin(r, g), b);
+
+    int value = valueTable[max];
+    if (max == min)
+        return qRgba(value, value, value, qAlpha(px));
+
+    int saturation = saturationTable[(255 * (max - min) + max / 2) / max];
+
+    float bottom = value * (255 - saturation) / 255.0f;
+    float scale = (value - bottom) / (max - min);
+
+    return qRgba((int) (bottom + (r - min) * scale + 0.5f),
+                 (int) (bottom + (g - min) * scale + 0.5f),
+                 (int) (bottom + (b - min) * scale + 0.5f),
+                 qAlpha(px));
+}
+
+/*!
+ * \brief The EnhanceKernel struct
+ * Auto-enhances a band in place
+ */
+struct EnhanceKernel
+{
+    QImage* image;
+    const int* valueTable;
+    const int* saturationTable;
+
+    void operator()(const ScanlineBand& band) const
+    {
+        int width = image->width();
+        for (int j = band.firstLine; j <= band.lastLine; j++) {
+            QRgb* line = reinterpret_cast<QRgb*>(image->scanLine(j));
+            for (int i = 0; i < width; i++)
+                line[i] = enhancePixel(line[i], valueTable, saturationTable);
+        }
+    }
+};
+
+/*!
+ * \brief The BalanceMatrix struct
+ * A ColorBalance matrix for channels from 0 to 255
+ */
+struct BalanceMatrix
+{
+    float m[3][4];
+};
+
+/*!
+ * \brief balancePixels
+ * Like ColorBalance::transformPixel(), channels are truncated and clamped,
+ * and the alpha channel is left as it is
+ * \param pixels
+ * \param count
+ * \param matrix
+ */
+static void balancePixels(QRgb* pixels, int count, const BalanceMatrix& matrix)
+{
+    const float (*m)[4] = matrix.m;
+    int i = 0;
+
+#if defined(__SSE2__)
+    // One pixel per vector, its lanes in memory order: blue, green, red,
+    // alpha.  Each column holds what one channel adds to each of the lanes.
+    const __m128 red_column = _mm_setr_ps(m[2][0], m[1][0], m[0][0], 0.0f);
+    const __m128 green_column = _mm_setr_ps(m[2][1], m[1][1], m[0][1], 0.0f);
+    const __m128 blue_column = _mm_setr_ps(m[2][2], m[1][2], m[0][2], 0.0f);
+    const __m128 offsets = _mm_setr_ps(m[2][3], m[1][3], m[0][3], 0.0f);
+    const __m128 alpha_column = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; i + 2 <= count; i += 2) {
+        __m128i px = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pixels + i)),
+                                       zero);
+        __m128i out[2];
+        for (int k = 0; k < 2; k++) {
+            __m128i words = (k == 0) ? px : _mm_unpackhi_epi64(px, px);
+            __m128 channels = _mm_cvtepi32_ps(_mm_unpacklo_epi16(words, zero));
+
+            __m128 x = _mm_add_ps(offsets,
+                                  _mm_mul_ps(red_column, _mm_shuffle_ps(channels, channels, 0xaa)));
+            x = _mm_add_ps(x, _mm_mul_ps(green_column, _mm_shuffle_ps(channels, channels, 0x55)));
+            x = _mm_add_ps(x, _mm_mul_ps(blue_column, _mm_shuffle_ps(channels, channels, 0x00)));
+            x = _mm_add_ps(x, _mm_mul_ps(alpha_column, _mm_shuffle_ps(channels, channels, 0xff)));
+            out[k] = _mm_cvttps_epi32(x);
+        }
+
+        // saturating packs do the clamping
+        __m128i packed = _mm_packus_epi16(_mm_packs_epi32(out[0], out[1]), zero);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(pixels + i), packed);
+    }
+#elif defined(GALLERY_IMAGING_NEON)
+    // Eight pixels at a time, split into their blue, green, red and alpha
+    // bytes, worked through four at a time.
+    for (; i + 8 <= count; i += 8) {
+        uint8x8x4_t px = vld4_u8(reinterpret_cast<const quint8*>(pixels + i));
+        uint16x8_t blue = vmovl_u8(px.val[0]);
+        uint16x8_t green = vmovl_u8(px.val[1]);
+        uint16x8_t red = vmovl_u8(px.val[2]);
+
+        uint16x4_t results[3][2];
+        for (int half = 0; half < 2; half++) {
+            float32x4_t r = vcvtq_f32_u32(vmovl_u16(half ? vget_high_u16(red) : vget_low_u16(red)));
+            float32x4_t g = vcvtq_f32_u32(vmovl_u16(half ? vget_high_u16(green) : vget_low_u16(green)));
+            float32x4_t b = vcvtq_f32_u32(vmovl_u16(half ? vget_high_u16(blue) : vget_low_u16(blue)));
+
+            for (int row = 0; row < 3; row++) {
+                float32x4_t x = vdupq_n_f32(m[row][3]);
+                x = vmlaq_n_f32(x, r, m[row][0]);
+                x = vmlaq_n_f32(x, g, m[row][1]);
+                x = vmlaq_n_f32(x, b, m[row][2]);
+                // negative values saturate to zero
+                results[row][half] = vqmovn_u32(vcvtq_u32_f32(x));
+            }
+        }
+
+        px.val[2] = vqmovn_u16(vcombine_u16(results[0][0], results[0][1]));
+        px.val[1] = vqmovn_u16(vcombine_u16(results[1][0], results[1][1]));
+        px.val[0] = vqmovn_u16(vcombine_u16(results[2][0], results[2][1]));
+        vst4_u8(reinterpret_cast<quint8*>(pixels + i), px);
+    }
+#endif
+
+    for (; i < count; i++) {
+        QRgb px = pixels[i];
+        float red = qRed(px);
+        float green = qGreen(px);
+        float blue = qBlue(px);
+
+        int channels[3];
+        for (int row = 0; row < 3; row++) {
+            // summed in the same order as the vector code
+            float x = m[row][3] + m[row][0] * red + m[row][1] * green + m[row][2] * blue;
+            channels[row] = qBound(0, (int) x, 255);
+        }
+
+        pixels[i] = qRgba(channels[0], channels[1], channels[2], qAlpha(px));
+    }
+}
+
+/*!
+ * \brief The BalanceKernel struct
+ * Color balances a band in place
+ */
+struct BalanceKernel
+{
+    QImage* image;
+    const BalanceMatrix* matrix;
+
+    void operator()(const ScanlineBand& band) const
+    {
+        int width = image->width();
+        for (int j = band.firstLine; j <= band.lastLine; j++)
+            balancePixels(reinterpret_cast<QRgb*>(image->scanLine(j)), width, *matrix);
+    }
+};
+
 /*!
  * \brief HSVTransformation::transformPixel
  * \param pixel_color
@@ -42,6 +369,16 @@ QColor HSVTransformation::transformPixel(const QColor &pixel_color) const
     return result;
 }
 
+/*!
+ * \brief HSVTransformation::remapValue
+ * \param value
+ * \return what the transformation turns an HSV value into
+ */
+int HSVTransformation::remapValue(int value) const
+{
+    return remap_table_[value];
+}
+
 /*!
  * \brief IntensityHistogram::IntensityHistogram
  * \param basis_image
@@ -54,17 +391,58 @@ IntensityHistogram::IntensityHistogram(const QImage& basis_image)
     int width = basis_image.width();
     int height = basis_image.height();
 
-    for (int j = 0; j < height; j++) {
-        QApplication::processEvents();
+    switch (basis_image.format()) {
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32:
+    case QImage::Format_ARGB32_Premultiplied:
+        countScanlines(basis_image);
+        break;
 
-        for (int i = 0; i < width; i++) {
-            QColor c = QColor(basis_image.pixel(i, j));
-            int intensity = c.value();
-            m_counts[intensity]++;
+    default:
+        for (int j = 0; j < height; j++) {
+            QApplication::processEvents();
+
+            for (int i = 0; i < width; i++) {
+                QColor c = QColor(basis_image.pixel(i, j));
+                int intensity = c.value();
+                m_counts[intensity]++;
+            }
         }
+        break;
     }
 
-    float pixel_count = (float)(width * height);
+    computeProbabilities();
+}
+
+/*!
+ * \brief IntensityHistogram::IntensityHistogram
+ * The histogram of an image after a transformation has remapped its
+ * intensities, worked out without transforming the image
+ * \param basis the histogram of the image
+ * \param transformation
+ */
+IntensityHistogram::IntensityHistogram(const IntensityHistogram& basis,
+                                       const HSVTransformation& transformation)
+{
+    for (int i = 0; i < 256; i++)
+        m_counts[i] = 0;
+
+    for (int i = 0; i < 256; i++)
+        m_counts[transformation.remapValue(i)] += basis.m_counts[i];
+
+    computeProbabilities();
+}
+
+/*!
+ * \brief IntensityHistogram::computeProbabilities
+ */
+void IntensityHistogram::computeProbabilities()
+{
+    int total = 0;
+    for (int i = 0; i < 256; i++)
+        total += m_counts[i];
+
+    float pixel_count = (float) total;
     float accumulator = 0.0f;
     for (int i = 0; i < 256; i++) {
         m_probabilities[i] = ((float) m_counts[i]) / pixel_count;
@@ -73,6 +451,26 @@ IntensityHistogram::IntensityHistogram(const QImage& basis_image)
     }
 }
 
+/*!
+ * \brief IntensityHistogram::countScanlines
+ * Counts a 32-bit image a scanline at a time.  Large images are split into a
+ * band of scanlines per core, each counted into its own histogram, and the
+ * histograms are added up at the end.
+ * \param basis_image
+ */
+void IntensityHistogram::countScanlines(const QImage& basis_image)
+{
+    QVector<BandCounts> band_counts(bandCount(basis_image));
+
+    CountKernel kernel = { &basis_image, band_counts.data() };
+    forEachBand(basis_image, kernel);
+
+    foreach (const BandCounts& band, band_counts) {
+        for (int i = 0; i < 256; i++)
+            m_counts[i] += band.counts[i];
+    }
+}
+
 /*!
  * \brief IntensityHistogram::getCumulativeProbability
  * \param level
@@ -168,6 +566,24 @@ float ToneExpansionTransformation::highDiscardMass() const
     return m_highDiscardMass;
 }
 
+/*!
+ * \brief ToneExpansionTransformation::lowKink
+ * \return the value at and below which everything goes to black
+ */
+int ToneExpansionTransformation::lowKink() const
+{
+    return m_lowKink;
+}
+
+/*!
+ * \brief ToneExpansionTransformation::highKink
+ * \return the value at and above which everything goes to white
+ */
+int ToneExpansionTransformation::highKink() const
+{
+    return m_highKink;
+}
+
 
 /*!
  * \brief HermiteGammaApproximationFunction::HermiteGammaApproximationFunction
@@ -245,6 +661,7 @@ const int AutoEnhanceTransformation::SHADOW_DETECT_INTENSITY_RANGE =
         AutoEnhanceTransformation::SHADOW_DETECT_MIN_INTENSITY;
 const int AutoEnhanceTransformation::EMPIRICAL_DARK = 40;
 const float AutoEnhanceTransformation::SHADOW_AGGRESSIVENESS_MUL = 0.45f;
+const int AutoEnhanceTransformation::MAX_ANALYSIS_PIXELS = 1024 * 1024;
 /*!
  * \brief AutoEnhanceTransformation::AutoEnhanceTransformation
  * \param basis
@@ -289,28 +706,37 @@ AutoEnhanceTransformation::AutoEnhanceTransformation(const QImage& basis)
         m_shadowTransform
                 = new ShadowDetailTransformation(shadow_trans_effect_size);
 
-        QImage shadow_corrected_image = QImage(basis);
-        // Can't write into indexed images, due to a limitation in Qt.
-        if (shadow_corrected_image.format() == QImage::Format_Indexed8)
-            shadow_corrected_image = shadow_corrected_image.convertToFormat(
-                        QImage::Format_RGB32);
+        // The shadow detail only moves each pixel's value, so the histogram
+        // of the shadow corrected image follows from the one already made.
+        m_toneExpansionTransform = new ToneExpansionTransformation(
+                    IntensityHistogram(histogram, *m_shadowTransform), 0.005f, 0.995f);
 
-        for (int j = 0; j < shadow_corrected_image.height(); j++) {
-            QApplication::processEvents();
+    } else {
+        m_toneExpansionTransform = new ToneExpansionTransformation(histogram);
+    }
 
-            for (int i = 0; i < shadow_corrected_image.width(); i++) {
-                QColor px = m_shadowTransform->transformPixel(
-                            QColor(shadow_corrected_image.pixel(i, j)));
-                shadow_corrected_image.setPixel(i, j, px.rgb());
-            }
-        }
+    buildRemapTables();
+}
 
-        m_toneExpansionTransform = new ToneExpansionTransformation(
-                    IntensityHistogram(shadow_corrected_image), 0.005f, 0.995f);
+/*!
+ * \brief AutoEnhanceTransformation::buildRemapTables
+ * Folds the shadow detail, the tone expansion and the saturation boost into
+ * a table for the value and one for the saturation
+ */
+void AutoEnhanceTransformation::buildRemapTables()
+{
+    /* if tone expansion occurs, boost saturation to compensate for boosted
+     dynamic range */
+    float compensation_multiplier = 1.0f;
+    if (!m_toneExpansionTransform->isIdentity())
+        compensation_multiplier =
+                (m_toneExpansionTransform->lowDiscardMass() < 0.01f) ? 1.02f : 1.10f;
 
-    } else {
-        m_toneExpansionTransform = new ToneExpansionTransformation(
-                    IntensityHistogram(basis));
+    for (int i = 0; i < 256; i++) {
+        int v = m_shadowTransform ? m_shadowTransform->remapValue(i) : i;
+        remap_table_[i] = m_toneExpansionTransform->remapValue(v);
+
+        m_saturationTable[i] = clampi((int) (((float) i) * compensation_multiplier), 0, 255);
     }
 }
 
@@ -332,36 +758,130 @@ AutoEnhanceTransformation::~AutoEnhanceTransformation()
 QColor AutoEnhanceTransformation::transformPixel(
         const QColor& pixel_color) const
 {
-    QColor px = pixel_color;
+    QColor px;
 
-    if (m_shadowTransform)
-        px = m_shadowTransform->transformPixel(px);
+    int h, s, v;
+    pixel_color.getHsv(&h, &s, &v);
+    px.setHsv(h, m_saturationTable[s], remap_table_[v]);
 
-    px = m_toneExpansionTransform->transformPixel(px);
+    return px;
+}
 
-    /* if tone expansion occurs, boost saturation to compensate for boosted
-     dynamic range */
-    if (!m_toneExpansionTransform->isIdentity()) {
-        int h, s, v;
-        px.getHsv(&h, &s, &v);
+/*!
+ * \brief AutoEnhanceTransformation::apply
+ * Enhances a whole image in one pass, a band of scanlines per core.  Unlike
+ * transformPixel() the hue isn't rounded to whole degrees on the way.
+ * \param image
+ * \return the enhanced image, in a 32-bit format
+ */
+QImage AutoEnhanceTransformation::apply(const QImage& image) const
+{
+    QImage result;
+    if (image.format() == QImage::Format_RGB32 || image.format() == QImage::Format_ARGB32)
+        result = image.copy();
+    else
+        result = image.convertToFormat(image.hasAlphaChannel()
+                                       ? QImage::Format_ARGB32 : QImage::Format_RGB32);
 
-        float compensation_multiplier =
-                (m_toneExpansionTransform->lowDiscardMass() < 0.01f) ? 1.02f : 1.10f;
+    // detach once up front, so the bands all write into the same pixels
+    result.bits();
 
-        s = (int) (((float) s) * compensation_multiplier);
-        s = clampi(s, 0, 255);
+    EnhanceKernel kernel = { &result, remap_table_, m_saturationTable };
+    forEachBand(result, kernel);
 
-        px.setHsv(h, s, v);
-    }
+    return result;
+}
 
-    return px;
+/*!
+ * \brief AutoEnhanceTransformation::transformTile \reimp
+ * \param tile
+ */
+void AutoEnhanceTransformation::transformTile(QImage* tile) const
+{
+    *tile = apply(*tile);
 }
 
+/*!
+ * \brief AutoEnhanceTransformation::isIdentity
+ * \return
+ */
 bool AutoEnhanceTransformation::isIdentity() const
 {
     return false;
 }
 
+/*!
+ * \brief AutoEnhanceTransformation::lowKink
+ * \return
+ */
+int AutoEnhanceTransformation::lowKink() const
+{
+    return m_toneExpansionTransform->lowKink();
+}
+
+/*!
+ * \brief AutoEnhanceTransformation::highKink
+ * \return
+ */
+int AutoEnhanceTransformation::highKink() const
+{
+    return m_toneExpansionTransform->highKink();
+}
+
+/*!
+ * \brief AutoEnhanceTransformation::analysisSize
+ * \param size
+ * \return the size, scaled down to no more than MAX_ANALYSIS_PIXELS
+ */
+QSize AutoEnhanceTransformation::analysisSize(const QSize& size)
+{
+    qint64 pixels = (qint64) size.width() * size.height();
+    if (pixels <= MAX_ANALYSIS_PIXELS)
+        return size;
+
+    qreal scale = qSqrt((qreal) MAX_ANALYSIS_PIXELS / pixels);
+    return QSize(qMax(1, (int) (size.width() * scale)),
+                 qMax(1, (int) (size.height() * scale)));
+}
+
+/*!
+ * \brief AutoEnhanceTransformation::analysisProxy
+ * The statistics the enhancement is worked out from hardly change at a lower
+ * resolution, so they can be taken from a smaller copy of the image and the
+ * result applied to the full one
+ * \param image
+ * \return the image, scaled down to no more than MAX_ANALYSIS_PIXELS
+ */
+QImage AutoEnhanceTransformation::analysisProxy(const QImage& image)
+{
+    QSize size = analysisSize(image.size());
+    if (size == image.size())
+        return image;
+
+    return image.scaled(size, Qt::IgnoreAspectRatio, Qt::FastTransformation);
+}
+
+/*!
+ * \brief AutoEnhanceTransformation::readAnalysisProxy
+ * Like analysisProxy(), but decodes the file straight at the smaller size
+ * where the format allows it (JPEG does), so the full image is never held
+ * \param path
+ * \return a null image if the file can't be read
+ */
+QImage AutoEnhanceTransformation::readAnalysisProxy(const QString& path)
+{
+    QImageReader reader(path);
+    QSize size = reader.size();
+    if (size.isValid())
+        reader.setScaledSize(analysisSize(size));
+
+    QImage image = reader.read();
+    if (image.isNull())
+        qWarning() << "Unable to read" << path << ":" << reader.errorString();
+
+    return analysisProxy(image);
+}
+
 
 /*!
  * \brief ColorBalance::ColorBalance
@@ -374,39 +894,77 @@ ColorBalance::ColorBalance(qreal brightness, qreal contrast, qreal saturation, q
 {
     qreal cos_h = qCos(hue * (M_PI / 180.0));
     qreal sin_h = qSin(hue * (M_PI / 180.0));
-    h1 = QVector4D(0.333333 * (1.0 - cos_h) + cos_h,
+    QVector4D h1 = QVector4D(0.333333 * (1.0 - cos_h) + cos_h,
                    0.333333 * (1.0 - cos_h) + 0.57735 * sin_h,
                    0.333333 * (1.0 - cos_h) - 0.57735 * sin_h,
                    0.0);
-    h2 = QVector4D(0.333333 * (1.0 - cos_h) - 0.57735 * sin_h,
+    QVector4D h2 = QVector4D(0.333333 * (1.0 - cos_h) - 0.57735 * sin_h,
                    0.333333 * (1.0 - cos_h) + cos_h,
                    0.333333 * (1.0 - cos_h) + 0.57735 * sin_h,
                    0.0);
-    h3 = QVector4D(0.333333 * (1.0 - cos_h) + 0.57735 * sin_h,
+    QVector4D h3 = QVector4D(0.333333 * (1.0 - cos_h) + 0.57735 * sin_h,
                    0.333333 * (1.0 - cos_h) - 0.57735 * sin_h,
                    0.333333 * (1.0 - cos_h) + cos_h,
                    0.0);
 
-    s1 = QVector4D((1.0 - saturation) * 0.3086 + saturation,
+    QVector4D s1 = QVector4D((1.0 - saturation) * 0.3086 + saturation,
                    (1.0 - saturation) * 0.6094,
                    (1.0 - saturation) * 0.0820,
                    0.0);
-    s2 = QVector4D((1.0 - saturation) * 0.3086,
+    QVector4D s2 = QVector4D((1.0 - saturation) * 0.3086,
                    (1.0 - saturation) * 0.6094 + saturation,
                    (1.0 - saturation) * 0.0820,
                    0.0);
-    s3 = QVector4D((1.0 - saturation) * 0.3086,
+    QVector4D s3 = QVector4D((1.0 - saturation) * 0.3086,
                    (1.0 - saturation) * 0.6094,
                    (1.0 - saturation) * 0.0820 + saturation,
                    0.0);
 
-    b1 = QVector4D(brightness, 0.0, 0.0, 0.0);
-    b2 = QVector4D(0.0, brightness, 0.0, 0.0);
-    b3 = QVector4D(0.0, 0.0, brightness, 0.0);
+    QVector4D b1 = QVector4D(brightness, 0.0, 0.0, 0.0);
+    QVector4D b2 = QVector4D(0.0, brightness, 0.0, 0.0);
+    QVector4D b3 = QVector4D(0.0, 0.0, brightness, 0.0);
+
+    QVector4D c1 = QVector4D(contrast, 0.0, 0.0, contrast * -0.5 + 0.5);
+    QVector4D c2 = QVector4D(0.0, contrast, 0.0, contrast * -0.5 + 0.5);
+    QVector4D c3 = QVector4D(0.0, 0.0, contrast, contrast * -0.5 + 0.5);
+
+    // Each step maps (R, G, B, 1) to (R', G', B', 1), so the steps chain
+    // up into one affine transformation: contrast * brightness * saturation
+    // * hue.
+    QVector4D steps[4][3] = {
+        { h1, h2, h3 },
+        { s1, s2, s3 },
+        { b1, b2, b3 },
+        { c1, c2, c3 }
+    };
+
+    qreal matrix[3][4] = {
+        { 1.0, 0.0, 0.0, 0.0 },
+        { 0.0, 1.0, 0.0, 0.0 },
+        { 0.0, 0.0, 1.0, 0.0 }
+    };
+
+    for (int step = 0; step < 4; step++) {
+        qreal composed[3][4];
+        for (int row = 0; row < 3; row++) {
+            const QVector4D& v = steps[step][row];
+            for (int column = 0; column < 4; column++) {
+                composed[row][column] = v.x() * matrix[0][column] +
+                        v.y() * matrix[1][column] + v.z() * matrix[2][column];
+            }
+            composed[row][3] += v.w();
+        }
 
-    c1 = QVector4D(contrast, 0.0, 0.0, contrast * -0.5 + 0.5);
-    c2 = QVector4D(0.0, contrast, 0.0, contrast * -0.5 + 0.5);
-    c3 = QVector4D(0.0, 0.0, contrast, contrast * -0.5 + 0.5);
+        for (int row = 0; row < 3; row++) {
+            for (int column = 0; column < 4; column++)
+                matrix[row][column] = composed[row][column];
+        }
+    }
+
+    for (int row = 0; row < 3; row++) {
+        for (int column = 0; column < 4; column++)
+            m_matrix[row][column] = (float) matrix[row][column];
+    }
 }
 
 /*!
@@ -417,57 +975,53 @@ ColorBalance::ColorBalance(qreal brightness, qreal contrast, qreal saturation, q
  */
 QColor ColorBalance::transformPixel(const QColor &pixel_color) const
 {
-    QVector4D pixel(pixel_color.red()/255.0, pixel_color.green()/255.0, pixel_color.blue()/255.0, 0.0);
-    pixel = transformHue(pixel);
-    pixel = transformSaturation(pixel);
-    pixel = transformBrightness(pixel);
-    pixel = transformContrast(pixel);
-    int red = qBound(0, (int)(pixel.x()*255), 255);
-    int green = qBound(0, (int)(pixel.y()*255), 255);
-    int blue = qBound(0, (int)(pixel.z()*255), 255);
-    return QColor(red, green, blue);
-}
+    float red = pixel_color.red() / 255.0;
+    float green = pixel_color.green() / 255.0;
+    float blue = pixel_color.blue() / 255.0;
+
+    int channels[3];
+    for (int row = 0; row < 3; row++) {
+        float x = m_matrix[row][0] * red + m_matrix[row][1] * green +
+                m_matrix[row][2] * blue + m_matrix[row][3];
+        channels[row] = qBound(0, (int)(x * 255), 255);
+    }
 
-/*!
- * \brief ColorBalance::transformBrightness transform the brightness
- * \param pixel the color in a 4D vector with (R, G, B, 1.0)
- * \return the brightness hue transformed color again as 4D vector
- */
-QVector4D ColorBalance::transformBrightness(const QVector4D &pixel) const
-{
-    return QVector4D(QVector4D::dotProduct(b1, pixel), QVector4D::dotProduct(b2, pixel),
-                     QVector4D::dotProduct(b3, pixel), 1.0);
+    return QColor(channels[0], channels[1], channels[2]);
 }
 
 /*!
- * \brief ColorBalance::transformContrast transforms the Contrast
- * \param pixel the color in a 4D vector with (R, G, B, 1.0)
- * \return the new contrast transformed color again as 4D vector
+ * \brief ColorBalance::apply transforms a whole image in place, a band of
+ * scanlines per core.  Images not in a 32-bit RGB format are converted to one
+ * first.  The alpha channel is kept.
+ * \param image
  */
-QVector4D ColorBalance::transformContrast(const QVector4D &pixel) const
+void ColorBalance::apply(QImage& image) const
 {
-    return QVector4D(QVector4D::dotProduct(c1, pixel), QVector4D::dotProduct(c2, pixel),
-                     QVector4D::dotProduct(c3, pixel), 1.0);
-}
+    if (image.format() != QImage::Format_RGB32 && image.format() != QImage::Format_ARGB32)
+        image = image.convertToFormat(image.hasAlphaChannel()
+                                      ? QImage::Format_ARGB32 : QImage::Format_RGB32);
+
+    // The matrix works on channels from 0 to 1; on the 0 to 255 of the
+    // pixels only the offsets need scaling.
+    BalanceMatrix matrix;
+    for (int row = 0; row < 3; row++) {
+        for (int column = 0; column < 3; column++)
+            matrix.m[row][column] = m_matrix[row][column];
+        matrix.m[row][3] = m_matrix[row][3] * 255.0f;
+    }
 
-/*!
- * \brief ColorBalance::transformSaturation transforms the saturation
- * \param pixel the color in a 4D vector with (R, G, B, 1.0)
- * \return the new saturation transformed color again as 4D vector
- */
-QVector4D ColorBalance::transformSaturation(const QVector4D &pixel) const
-{
-    return QVector4D(QVector4D::dotProduct(s1, pixel), QVector4D::dotProduct(s2, pixel),
-                     QVector4D::dotProduct(s3, pixel), 1.0);
+    // detach once up front, so the bands all write into the same pixels
+    image.bits();
+
+    BalanceKernel kernel = { &image, &matrix };
+    forEachBand(image, kernel);
 }
 
 /*!
- * \brief ColorBalance::transformHue transforms the hue
- * \param pixel the color in a 4D vector with (R, G, B, 1.0)
- * \return the new hue transformed color again as 4D vector
+ * \brief ColorBalance::transformTile \reimp
+ * \param tile
  */
-QVector4D ColorBalance::transformHue(const QVector4D &pixel) const
+void ColorBalance::transformTile(QImage* tile) const
 {
-    return QVector4D(QVector4D::dotProduct(h1, pixel), QVector4D::dotProduct(h2, pixel),
-                     QVector4D::dotProduct(h3, pixel), 1.0);
+    apply(*tile);
 }
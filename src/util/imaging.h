@@ -22,6 +22,8 @@
 
 #include <QColor>
 #include <QImage>
+#include <QSize>
+#include <QString>
 #include <QVector4D>
 
 /*!
@@ -46,6 +48,19 @@ inline float clampf(float x, float min, float max) {
     return (x < min) ? min : ((x > max) ? max : x);
 }
 
+/*!
+ * \brief The TileTransformation class
+ * A transformation that treats every part of an image on its own, so a large
+ * image can be put through it a tile at a time
+ */
+class TileTransformation
+{
+public:
+    virtual ~TileTransformation() { }
+
+    virtual void transformTile(QImage* tile) const = 0;
+};
+
 /*!
  * \brief The HSVTransformation class
  */
@@ -58,6 +73,8 @@ public:
     virtual QColor transformPixel(const QColor& pixel_color) const;
     virtual bool isIdentity() const = 0;
 
+    int remapValue(int value) const;
+
 protected:
     int remap_table_[256];
 };
@@ -69,11 +86,16 @@ class IntensityHistogram
 {
 public:
     IntensityHistogram(const QImage& basis_image);
+    IntensityHistogram(const IntensityHistogram& basis,
+                       const HSVTransformation& transformation);
     virtual ~IntensityHistogram() { }
 
     float getCumulativeProbability(int level);
 
 private:
+    void countScanlines(const QImage& basis_image);
+    void computeProbabilities();
+
     int m_counts[256];
     float m_probabilities[256];
     float m_cumulativeProbabilities[256];
@@ -96,6 +118,8 @@ public:
 
     float lowDiscardMass() const;
     float highDiscardMass() const;
+    int lowKink() const;
+    int highKink() const;
 
 private:
     void buildRemapTable();
@@ -144,7 +168,8 @@ private:
 /*!
  * \brief The AutoEnhanceTransformation class
  */
-class AutoEnhanceTransformation : public virtual HSVTransformation
+class AutoEnhanceTransformation : public virtual HSVTransformation,
+                                  public TileTransformation
 {
     static const int SHADOW_DETECT_MIN_INTENSITY;
     static const int SHADOW_DETECT_MAX_INTENSITY;
@@ -153,15 +178,29 @@ class AutoEnhanceTransformation : public virtual HSVTransformation
     static const float SHADOW_AGGRESSIVENESS_MUL;
 
 public:
+    static const int MAX_ANALYSIS_PIXELS;
+
     AutoEnhanceTransformation(const QImage& basis_image);
     virtual ~AutoEnhanceTransformation();
 
     QColor transformPixel(const QColor& pixel_color) const;
+    QImage apply(const QImage& image) const;
+    void transformTile(QImage* tile) const;
     bool isIdentity() const;
 
+    int lowKink() const;
+    int highKink() const;
+
+    static QSize analysisSize(const QSize& size);
+    static QImage analysisProxy(const QImage& image);
+    static QImage readAnalysisProxy(const QString& path);
+
 private:
+    void buildRemapTables();
+
     ShadowDetailTransformation* m_shadowTransform;
     ToneExpansionTransformation* m_toneExpansionTransform;
+    int m_saturationTable[256];
 };
 
 /*!
@@ -170,31 +209,19 @@ private:
  *
  * This implementation is a port of the one used in EditPreview.qml in the shader.
  */
-class ColorBalance
+class ColorBalance : public TileTransformation
 {
 public:
     ColorBalance(qreal brightness, qreal contrast, qreal saturation, qreal hue);
 
     QColor transformPixel(const QColor& pixel_color) const;
+    void apply(QImage& image) const;
+    void transformTile(QImage* tile) const;
 
 private:
-    QVector4D transformBrightness(const QVector4D& pixel) const;
-    QVector4D transformContrast(const QVector4D& pixel) const;
-    QVector4D transformSaturation(const QVector4D& pixel) const;
-    QVector4D transformHue(const QVector4D& pixel) const;
-
-    QVector4D h1;
-    QVector4D h2;
-    QVector4D h3;
-    QVector4D s1;
-    QVector4D s2;
-    QVector4D s3;
-    QVector4D b1;
-    QVector4D b2;
-    QVector4D b3;
-    QVector4D c1;
-    QVector4D c2;
-    QVector4D c3;
+    // the hue, saturation, brightness and contrast steps in one affine
+    // transformation of (R, G, B), with channels from 0 to 1
+    float m_matrix[3][4];
 };
 
 #endif  // GALLERY_UTIL_IMAGING_H_
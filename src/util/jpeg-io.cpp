@@ -0,0 +1,231 @@
+/*
+ * Copyright (C) 2014 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "jpeg-io.h"
+
+#include <QIODevice>
+
+/*!
+ * \brief jpegErrorExit
+ * \param cinfo
+ */
+static void jpegErrorExit(j_common_ptr cinfo)
+{
+    JpegErrorManager* error = reinterpret_cast<JpegErrorManager*>(cinfo->err);
+    (*cinfo->err->format_message)(cinfo, error->message);
+    longjmp(error->jump, 1);
+}
+
+/*!
+ * \brief jpegOutputMessage keeps libjpeg's warnings off stderr
+ * \param cinfo
+ */
+static void jpegOutputMessage(j_common_ptr cinfo)
+{
+    Q_UNUSED(cinfo);
+}
+
+/*!
+ * \brief initSource
+ * \param cinfo
+ */
+static void initSource(j_decompress_ptr cinfo)
+{
+    Q_UNUSED(cinfo);
+}
+
+/*!
+ * \brief fillInputBuffer
+ * \param cinfo
+ * \return
+ */
+static boolean fillInputBuffer(j_decompress_ptr cinfo)
+{
+    JpegSource* source = reinterpret_cast<JpegSource*>(cinfo->src);
+
+    qint64 count = source->device->read(reinterpret_cast<char*>(source->buffer),
+                                        JPEG_IO_BUFFER_SIZE);
+    if (count <= 0) {
+        // a truncated file is ended with an EOI marker, as libjpeg's own
+        // sources do
+        WARNMS(cinfo, JWRN_JPEG_EOF);
+        source->buffer[0] = (JOCTET) 0xFF;
+        source->buffer[1] = (JOCTET) JPEG_EOI;
+        count = 2;
+    }
+
+    source->pub.next_input_byte = source->buffer;
+    source->pub.bytes_in_buffer = count;
+
+    return TRUE;
+}
+
+/*!
+ * \brief skipInputData
+ * \param cinfo
+ * \param count
+ */
+static void skipInputData(j_decompress_ptr cinfo, long count)
+{
+    JpegSource* source = reinterpret_cast<JpegSource*>(cinfo->src);
+    if (count <= 0)
+        return;
+
+    while (count > (long) source->pub.bytes_in_buffer) {
+        count -= (long) source->pub.bytes_in_buffer;
+        fillInputBuffer(cinfo);
+    }
+
+    source->pub.next_input_byte += count;
+    source->pub.bytes_in_buffer -= count;
+}
+
+/*!
+ * \brief termSource
+ * \param cinfo
+ */
+static void termSource(j_decompress_ptr cinfo)
+{
+    Q_UNUSED(cinfo);
+}
+
+/*!
+ * \brief initDestination
+ * \param cinfo
+ */
+static void initDestination(j_compress_ptr cinfo)
+{
+    JpegDestination* destination = reinterpret_cast<JpegDestination*>(cinfo->dest);
+
+    destination->pub.next_output_byte = destination->buffer;
+    destination->pub.free_in_buffer = JPEG_IO_BUFFER_SIZE;
+}
+
+/*!
+ * \brief emptyOutputBuffer
+ * \param cinfo
+ * \return
+ */
+static boolean emptyOutputBuffer(j_compress_ptr cinfo)
+{
+    JpegDestination* destination = reinterpret_cast<JpegDestination*>(cinfo->dest);
+
+    if (destination->device->write(reinterpret_cast<const char*>(destination->buffer),
+                                   JPEG_IO_BUFFER_SIZE) != JPEG_IO_BUFFER_SIZE)
+        ERREXIT(cinfo, JERR_FILE_WRITE);
+
+    destination->pub.next_output_byte = destination->buffer;
+    destination->pub.free_in_buffer = JPEG_IO_BUFFER_SIZE;
+
+    return TRUE;
+}
+
+/*!
+ * \brief termDestination
+ * \param cinfo
+ */
+static void termDestination(j_compress_ptr cinfo)
+{
+    JpegDestination* destination = reinterpret_cast<JpegDestination*>(cinfo->dest);
+
+    qint64 count = JPEG_IO_BUFFER_SIZE - destination->pub.free_in_buffer;
+    if (count > 0 && destination->device->write(
+                reinterpret_cast<const char*>(destination->buffer), count) != count)
+        ERREXIT(cinfo, JERR_FILE_WRITE);
+}
+
+/*!
+ * \brief jpegSetErrorManager
+ * Has libjpeg errors jump back to error->jump, with the message in
+ * error->message, and keeps its warnings quiet
+ * \param error
+ * \param decoder
+ * \param encoder
+ */
+void jpegSetErrorManager(JpegErrorManager* error, jpeg_decompress_struct* decoder,
+                         jpeg_compress_struct* encoder)
+{
+    decoder->err = jpeg_std_error(&error->pub);
+    encoder->err = &error->pub;
+    error->pub.error_exit = jpegErrorExit;
+    error->pub.output_message = jpegOutputMessage;
+    error->message[0] = '\0';
+}
+
+/*!
+ * \brief jpegSetSource
+ * \param decoder
+ * \param source
+ * \param device
+ */
+void jpegSetSource(jpeg_decompress_struct* decoder, JpegSource* source, QIODevice* device)
+{
+    source->device = device;
+    source->pub.init_source = initSource;
+    source->pub.fill_input_buffer = fillInputBuffer;
+    source->pub.skip_input_data = skipInputData;
+    source->pub.resync_to_restart = jpeg_resync_to_restart;
+    source->pub.term_source = termSource;
+    source->pub.bytes_in_buffer = 0;
+    source->pub.next_input_byte = NULL;
+    decoder->src = &source->pub;
+}
+
+/*!
+ * \brief jpegSetDestination
+ * \param encoder
+ * \param destination
+ * \param device
+ */
+void jpegSetDestination(jpeg_compress_struct* encoder, JpegDestination* destination,
+                        QIODevice* device)
+{
+    destination->device = device;
+    destination->pub.init_destination = initDestination;
+    destination->pub.empty_output_buffer = emptyOutputBuffer;
+    destination->pub.term_destination = termDestination;
+    encoder->dest = &destination->pub;
+}
+
+/*!
+ * \brief jpegSaveMarkers
+ * Keeps the metadata markers (EXIF, XMP, ICC, comments) as the header is
+ * read.  JFIF and Adobe markers describe the encoding, so an encoder writes
+ * its own.
+ * \param decoder
+ */
+void jpegSaveMarkers(jpeg_decompress_struct* decoder)
+{
+    jpeg_save_markers(decoder, JPEG_COM, 0xFFFF);
+    for (int marker = JPEG_APP0 + 1; marker <= JPEG_APP0 + 15; marker++) {
+        if (marker != JPEG_APP0 + 14)
+            jpeg_save_markers(decoder, marker, 0xFFFF);
+    }
+}
+
+/*!
+ * \brief jpegCopyMarkers
+ * Writes the markers kept by jpegSaveMarkers(); the encoder has to have been
+ * started
+ * \param decoder
+ * \param encoder
+ */
+void jpegCopyMarkers(jpeg_decompress_struct* decoder, jpeg_compress_struct* encoder)
+{
+    for (jpeg_saved_marker_ptr marker = decoder->marker_list; marker != NULL;
+         marker = marker->next)
+        jpeg_write_marker(encoder, marker->marker, marker->data, marker->data_length);
+}
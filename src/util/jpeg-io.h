@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2014 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GALLERY_UTIL_JPEG_IO_H_
+#define GALLERY_UTIL_JPEG_IO_H_
+
+#include <csetjmp>
+#include <cstdio>
+
+extern "C" {
+#include <jpeglib.h>
+#include <jerror.h>
+}
+
+class QIODevice;
+
+// How much of the file is read or written at a time
+const int JPEG_IO_BUFFER_SIZE = 64 * 1024;
+
+/*!
+ * \brief The JpegErrorManager struct
+ * Turns libjpeg's fatal errors into a jump back to where the work started
+ */
+struct JpegErrorManager
+{
+    jpeg_error_mgr pub;
+    jmp_buf jump;
+    char message[JMSG_LENGTH_MAX];
+};
+
+/*!
+ * \brief The JpegSource struct
+ * Feeds libjpeg from a QIODevice
+ */
+struct JpegSource
+{
+    jpeg_source_mgr pub;
+    QIODevice* device;
+    JOCTET buffer[JPEG_IO_BUFFER_SIZE];
+};
+
+/*!
+ * \brief The JpegDestination struct
+ * Writes libjpeg's output to a QIODevice
+ */
+struct JpegDestination
+{
+    jpeg_destination_mgr pub;
+    QIODevice* device;
+    JOCTET buffer[JPEG_IO_BUFFER_SIZE];
+};
+
+void jpegSetErrorManager(JpegErrorManager* error, jpeg_decompress_struct* decoder,
+                         jpeg_compress_struct* encoder);
+void jpegSetSource(jpeg_decompress_struct* decoder, JpegSource* source, QIODevice* device);
+void jpegSetDestination(jpeg_compress_struct* encoder, JpegDestination* destination,
+                        QIODevice* device);
+
+void jpegSaveMarkers(jpeg_decompress_struct* decoder);
+void jpegCopyMarkers(jpeg_decompress_struct* decoder, jpeg_compress_struct* encoder);
+
+#endif  // GALLERY_UTIL_JPEG_IO_H_
@@ -0,0 +1,445 @@
+/*
+ * Copyright (C) 2014 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "jpeg-orientation.h"
+#include "jpeg-io.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QSaveFile>
+
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Markers libjpeg doesn't name
+static const int JPEG_SOI = 0xD8;
+static const int JPEG_SOS = 0xDA;
+
+static const int ORIENTATION_TAG = 0x0112;
+static const int TIFF_SHORT = 3;
+static const int IFD_ENTRY_SIZE = 12;
+
+// What precedes the TIFF structure in an APP1 marker holding EXIF
+static const char EXIF_HEADER[] = "Exif\0\0";
+static const int EXIF_HEADER_SIZE = 6;
+
+/*!
+ * \brief readShort
+ * \param data
+ * \param bigEndian
+ * \return
+ */
+static inline quint16 readShort(const uchar* data, bool bigEndian)
+{
+    return bigEndian ? (data[0] << 8) | data[1] : (data[1] << 8) | data[0];
+}
+
+/*!
+ * \brief readLong
+ * \param data
+ * \param bigEndian
+ * \return
+ */
+static inline quint32 readLong(const uchar* data, bool bigEndian)
+{
+    return bigEndian ?
+                ((quint32) readShort(data, true) << 16) | readShort(data + 2, true) :
+                ((quint32) readShort(data + 2, false) << 16) | readShort(data, false);
+}
+
+/*!
+ * \brief findOrientation
+ * Looks through the first IFD of an APP1 marker's EXIF for the orientation
+ * \param data the marker's contents, after its length
+ * \param length
+ * \param bigEndian set to the byte order of the EXIF
+ * \return where in data the orientation's value is, or -1 if there isn't one
+ * that can be overwritten
+ */
+static int findOrientation(const uchar* data, int length, bool* bigEndian)
+{
+    if (length < EXIF_HEADER_SIZE + 8 || memcmp(data, EXIF_HEADER, EXIF_HEADER_SIZE) != 0)
+        return -1;
+
+    const uchar* tiff = data + EXIF_HEADER_SIZE;
+    int tiff_length = length - EXIF_HEADER_SIZE;
+
+    if (tiff[0] == 'M' && tiff[1] == 'M')
+        *bigEndian = true;
+    else if (tiff[0] == 'I' && tiff[1] == 'I')
+        *bigEndian = false;
+    else
+        return -1;
+
+    if (readShort(tiff + 2, *bigEndian) != 42)
+        return -1;
+
+    // the offsets come from the file, so they're checked in 64 bits, where an
+    // offset near 4GB can't wrap around to look like it's in bounds
+    qint64 ifd = readLong(tiff + 4, *bigEndian);
+    if (ifd + 2 > tiff_length)
+        return -1;
+
+    int count = readShort(tiff + ifd, *bigEndian);
+    for (int i = 0; i < count; i++) {
+        qint64 entry = ifd + 2 + (qint64) i * IFD_ENTRY_SIZE;
+        if (entry + IFD_ENTRY_SIZE > tiff_length)
+            return -1;
+
+        if (readShort(tiff + entry, *bigEndian) != ORIENTATION_TAG)
+            continue;
+
+        // a single SHORT sits at the start of the entry's value field
+        if (readShort(tiff + entry + 2, *bigEndian) != TIFF_SHORT ||
+                readLong(tiff + entry + 4, *bigEndian) != 1)
+            return -1;
+
+        return EXIF_HEADER_SIZE + (int) entry + 8;
+    }
+
+    return -1;
+}
+
+/*!
+ * \brief findOrientationInFile
+ * Walks the markers ahead of the image data, reading only the APP1 ones
+ * \param fd
+ * \param bigEndian set to the byte order of the EXIF
+ * \return the file offset of the orientation's value, or -1 if there isn't
+ * one that can be overwritten
+ */
+static qint64 findOrientationInFile(int fd, bool* bigEndian)
+{
+    uchar header[4];
+    if (pread(fd, header, 2, 0) != 2 || header[0] != 0xFF || header[1] != JPEG_SOI)
+        return -1;
+
+    qint64 offset = 2;
+    for (;;) {
+        if (pread(fd, header, 4, offset) != 4 || header[0] != 0xFF)
+            return -1;
+
+        // markers may be padded with any number of 0xFFs
+        if (header[1] == 0xFF) {
+            offset++;
+            continue;
+        }
+
+        if (header[1] == JPEG_SOS || header[1] == JPEG_EOI)
+            return -1;
+
+        int length = (header[2] << 8) | header[3];
+        if (length < 2)
+            return -1;
+
+        if (header[1] == JPEG_APP0 + 1) {
+            QByteArray data(length - 2, '\0');
+            if (pread(fd, data.data(), data.size(), offset + 4) != data.size())
+                return -1;
+
+            int found = findOrientation(reinterpret_cast<const uchar*>(data.constData()),
+                                        data.size(), bigEndian);
+            if (found >= 0)
+                return offset + 4 + found;
+        }
+
+        offset += 2 + length;
+    }
+}
+
+/*!
+ * \brief transformBlock
+ * Turns one block of DCT coefficients.  Mirroring a block negates its odd
+ * frequencies in that direction; transposing it transposes the coefficients.
+ * \param source
+ * \param dest
+ * \param transpose
+ * \param flipX
+ * \param flipY
+ */
+static inline void transformBlock(const JCOEF* source, JCOEF* dest, bool transpose,
+                                  bool flipX, bool flipY)
+{
+    for (int row = 0; row < DCTSIZE; row++) {
+        for (int column = 0; column < DCTSIZE; column++) {
+            JCOEF value = source[row * DCTSIZE + column];
+            if ((flipX && (column & 1)) != (flipY && (row & 1)))
+                value = -value;
+
+            dest[transpose ? column * DCTSIZE + row : row * DCTSIZE + column] = value;
+        }
+    }
+}
+
+/*!
+ * \brief divideRoundingUp
+ * \param value
+ * \param divisor
+ * \return
+ */
+static inline int divideRoundingUp(qint64 value, int divisor)
+{
+    return (int) ((value + divisor - 1) / divisor);
+}
+
+/*!
+ * \brief transformCoefficients
+ * Reads the source's DCT coefficients, rearranges them and writes them out,
+ * with the metadata copied across and the EXIF orientation reset.  Nothing
+ * here may need destroying, as a libjpeg error jumps out of it.
+ * \param decoder
+ * \param encoder
+ * \param orientation
+ */
+static void transformCoefficients(jpeg_decompress_struct* decoder,
+                                  jpeg_compress_struct* encoder, Orientation orientation)
+{
+    bool transpose;
+    bool flip_x;
+    bool flip_y;
+    OrientationCorrection::fromOrientation(orientation).getPixelMapping(
+                &transpose, &flip_x, &flip_y);
+
+    jpegSaveMarkers(decoder);
+    jpeg_read_header(decoder, TRUE);
+
+    // Blocks can only be moved whole, so a partial row or column of MCUs that
+    // would be flipped to the leading edge is trimmed off, as jpegtran -trim
+    // does.
+    int max_h = decoder->max_h_samp_factor;
+    int max_v = decoder->max_v_samp_factor;
+    JDIMENSION width = decoder->image_width;
+    JDIMENSION height = decoder->image_height;
+    if (flip_x)
+        width -= width % (max_h * DCTSIZE);
+    if (flip_y)
+        height -= height % (max_v * DCTSIZE);
+    if (width == 0 || height == 0)
+        ERREXIT(decoder, JERR_EMPTY_IMAGE);
+
+    // the arrays have to be asked for before the coefficients are read
+    jvirt_barray_ptr dest_coefficients[MAX_COMPONENTS];
+    for (int c = 0; c < decoder->num_components; c++) {
+        jpeg_component_info* component = decoder->comp_info + c;
+        int width_in_blocks = divideRoundingUp((qint64) width * component->h_samp_factor,
+                                               max_h * DCTSIZE);
+        int height_in_blocks = divideRoundingUp((qint64) height * component->v_samp_factor,
+                                                max_v * DCTSIZE);
+        int dest_h = transpose ? component->v_samp_factor : component->h_samp_factor;
+        int dest_v = transpose ? component->h_samp_factor : component->v_samp_factor;
+        int dest_width = transpose ? height_in_blocks : width_in_blocks;
+        int dest_height = transpose ? width_in_blocks : height_in_blocks;
+
+        dest_coefficients[c] = (*decoder->mem->request_virt_barray)(
+                    (j_common_ptr) decoder, JPOOL_IMAGE, TRUE,
+                    divideRoundingUp(dest_width, dest_h) * dest_h,
+                    divideRoundingUp(dest_height, dest_v) * dest_v, dest_v);
+    }
+
+    jvirt_barray_ptr* source_coefficients = jpeg_read_coefficients(decoder);
+
+    jpeg_copy_critical_parameters(decoder, encoder);
+    encoder->image_width = transpose ? height : width;
+    encoder->image_height = transpose ? width : height;
+    if (transpose) {
+        for (int c = 0; c < encoder->num_components; c++) {
+            jpeg_component_info* component = encoder->comp_info + c;
+            int h_samp_factor = component->h_samp_factor;
+            component->h_samp_factor = component->v_samp_factor;
+            component->v_samp_factor = h_samp_factor;
+        }
+
+        for (int q = 0; q < NUM_QUANT_TBLS; q++) {
+            JQUANT_TBL* table = encoder->quant_tbl_ptrs[q];
+            if (table == NULL)
+                continue;
+
+            for (int row = 0; row < DCTSIZE; row++) {
+                for (int column = row + 1; column < DCTSIZE; column++) {
+                    UINT16 value = table->quantval[row * DCTSIZE + column];
+                    table->quantval[row * DCTSIZE + column] =
+                            table->quantval[column * DCTSIZE + row];
+                    table->quantval[column * DCTSIZE + row] = value;
+                }
+            }
+        }
+    }
+
+    for (int c = 0; c < decoder->num_components; c++) {
+        jpeg_component_info* component = decoder->comp_info + c;
+        int width_in_blocks = divideRoundingUp((qint64) width * component->h_samp_factor,
+                                               max_h * DCTSIZE);
+        int height_in_blocks = divideRoundingUp((qint64) height * component->v_samp_factor,
+                                                max_v * DCTSIZE);
+        int dest_width = transpose ? height_in_blocks : width_in_blocks;
+        int dest_height = transpose ? width_in_blocks : height_in_blocks;
+
+        for (int y = 0; y < dest_height; y++) {
+            JBLOCKROW dest_row = (*decoder->mem->access_virt_barray)(
+                        (j_common_ptr) decoder, dest_coefficients[c], y, 1, TRUE)[0];
+
+            for (int x = 0; x < dest_width; x++) {
+                int source_x = transpose ? y : x;
+                int source_y = transpose ? x : y;
+                if (flip_x)
+                    source_x = width_in_blocks - 1 - source_x;
+                if (flip_y)
+                    source_y = height_in_blocks - 1 - source_y;
+
+                JBLOCKROW source_row = (*decoder->mem->access_virt_barray)(
+                            (j_common_ptr) decoder, source_coefficients[c], source_y, 1,
+                            FALSE)[0];
+                transformBlock(source_row[source_x], dest_row[x], transpose, flip_x, flip_y);
+            }
+        }
+    }
+
+    jpeg_write_coefficients(encoder, dest_coefficients);
+
+    // the pixels are upright now
+    for (jpeg_saved_marker_ptr marker = decoder->marker_list; marker != NULL;
+         marker = marker->next) {
+        bool big_endian;
+        int found = (marker->marker == JPEG_APP0 + 1) ?
+                    findOrientation(marker->data, marker->data_length, &big_endian) : -1;
+        if (found >= 0) {
+            marker->data[found] = big_endian ? 0 : TOP_LEFT_ORIGIN;
+            marker->data[found + 1] = big_endian ? TOP_LEFT_ORIGIN : 0;
+        }
+    }
+    jpegCopyMarkers(decoder, encoder);
+
+    jpeg_finish_compress(encoder);
+    jpeg_finish_decompress(decoder);
+}
+
+/*!
+ * \brief JpegOrientation::readOrientation
+ * \param path
+ * \return the EXIF orientation, or TOP_LEFT_ORIGIN if the file doesn't have
+ * one
+ */
+Orientation JpegOrientation::readOrientation(const QString& path)
+{
+    int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY);
+    if (fd < 0)
+        return TOP_LEFT_ORIGIN;
+
+    Orientation orientation = TOP_LEFT_ORIGIN;
+    bool big_endian;
+    qint64 offset = findOrientationInFile(fd, &big_endian);
+
+    uchar value[2];
+    if (offset >= 0 && pread(fd, value, 2, offset) == 2) {
+        int stored = readShort(value, big_endian);
+        if (stored >= MIN_ORIENTATION && stored <= MAX_ORIENTATION)
+            orientation = static_cast<Orientation>(stored);
+    }
+
+    ::close(fd);
+
+    return orientation;
+}
+
+/*!
+ * \brief JpegOrientation::patchOrientation
+ * Overwrites the orientation in the file's EXIF with a single write.  Files
+ * without an orientation to overwrite are left alone, as adding one means
+ * rewriting the metadata.
+ * \param path
+ * \param orientation
+ * \return true if the orientation was written
+ */
+bool JpegOrientation::patchOrientation(const QString& path, Orientation orientation)
+{
+    int fd = ::open(QFile::encodeName(path).constData(), O_RDWR);
+    if (fd < 0)
+        return false;
+
+    bool big_endian;
+    qint64 offset = findOrientationInFile(fd, &big_endian);
+
+    bool patched = false;
+    if (offset >= 0) {
+        uchar value[2];
+        value[0] = big_endian ? 0 : orientation;
+        value[1] = big_endian ? orientation : 0;
+
+        patched = (pwrite(fd, value, 2, offset) == 2);
+    }
+
+    ::close(fd);
+
+    return patched;
+}
+
+/*!
+ * \brief JpegOrientation::transformLossless
+ * Writes the source with its pixels turned to the given orientation's
+ * correction and the EXIF orientation reset, without decoding it.  A partial
+ * row or column of MCUs that would end up on the top or left edge is trimmed
+ * off, so the image may lose up to 15 pixels on those edges.  The
+ * destination may be the source; it's only replaced once the new image is
+ * complete.
+ * \param sourcePath
+ * \param destPath
+ * \param orientation the image's present orientation
+ * \return
+ */
+bool JpegOrientation::transformLossless(const QString& sourcePath, const QString& destPath,
+                                        Orientation orientation)
+{
+    QFile source(sourcePath);
+    if (!source.open(QIODevice::ReadOnly))
+        return false;
+
+    QSaveFile dest(destPath);
+    if (!dest.open(QIODevice::WriteOnly))
+        return false;
+
+    // Everything that has to be cleaned up is made before the setjmp(), as a
+    // libjpeg error jumps straight back to it.
+    jpeg_decompress_struct decoder;
+    jpeg_compress_struct encoder;
+    JpegErrorManager error;
+    JpegSource input;
+    JpegDestination output;
+
+    jpegSetErrorManager(&error, &decoder, &encoder);
+    jpeg_create_decompress(&decoder);
+    jpeg_create_compress(&encoder);
+    jpegSetSource(&decoder, &input, &source);
+    jpegSetDestination(&encoder, &output, &dest);
+
+    bool transformed = false;
+    if (setjmp(error.jump) == 0) {
+        transformCoefficients(&decoder, &encoder, orientation);
+        transformed = true;
+    } else {
+        qDebug("Unable to transform %s: %s", qPrintable(sourcePath), error.message);
+    }
+
+    jpeg_destroy_compress(&encoder);
+    jpeg_destroy_decompress(&decoder);
+
+    if (!transformed) {
+        dest.cancelWriting();
+        return false;
+    }
+
+    return dest.commit();
+}
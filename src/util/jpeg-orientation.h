@@ -0,0 +1,40 @@
+/*
+ * Copyright (C) 2014 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GALLERY_UTIL_JPEG_ORIENTATION_H_
+#define GALLERY_UTIL_JPEG_ORIENTATION_H_
+
+#include "orientation.h"
+
+#include <QString>
+
+/**
+  * Changes a JPEG's orientation without decoding it.  patchOrientation()
+  * overwrites the EXIF orientation where it already is in the file, so
+  * nothing else is rewritten.  transformLossless() is for viewers that ignore
+  * EXIF: it turns the image's DCT blocks rather than its pixels, so there's no
+  * loss of quality.
+  */
+class JpegOrientation
+{
+public:
+    static Orientation readOrientation(const QString& path);
+    static bool patchOrientation(const QString& path, Orientation orientation);
+    static bool transformLossless(const QString& sourcePath, const QString& destPath,
+                                  Orientation orientation);
+};
+
+#endif  // GALLERY_UTIL_JPEG_ORIENTATION_H_
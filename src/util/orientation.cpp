@@ -17,10 +17,120 @@
  * Lucas Beeler <lucas@yorba.org>
  */
 
+#include <algorithm>
 #include <cstdio>
+#include <cstring>
 
 #include "orientation.h"
 
+// Square of pixels a transpose works on at a time, so the rows it reads and
+// the rows it writes both stay in cache
+static const int TRANSPOSE_BLOCK = 32;
+
+/*!
+ * \brief The Pixel24 struct
+ * A pixel of the three byte formats, which have no integer type
+ */
+struct Pixel24
+{
+    uchar bytes[3];
+};
+Q_STATIC_ASSERT(sizeof(Pixel24) == 3);
+
+/*!
+ * \brief flipPixels
+ * Copies source into dest, which is the same size, mirrored horizontally
+ * and/or vertically
+ * \param source
+ * \param dest
+ * \param flip_x
+ * \param flip_y
+ */
+template <typename Pixel>
+static void flipPixels(const QImage& source, QImage* dest, bool flip_x, bool flip_y)
+{
+    int width = source.width();
+    int height = source.height();
+    const uchar* from_bits = source.constBits();
+    int from_stride = source.bytesPerLine();
+    uchar* to_bits = dest->bits();
+    int to_stride = dest->bytesPerLine();
+
+    for (int j = 0; j < height; j++) {
+        const Pixel* from = reinterpret_cast<const Pixel*>(
+                    from_bits + (qint64) (flip_y ? height - 1 - j : j) * from_stride);
+        Pixel* to = reinterpret_cast<Pixel*>(to_bits + (qint64) j * to_stride);
+
+        if (flip_x)
+            std::reverse_copy(from, from + width, to);
+        else
+            memcpy(to, from, width * sizeof(Pixel));
+    }
+}
+
+/*!
+ * \brief transposePixels
+ * Copies source into dest, which is source's height wide and width high, so
+ * that source's columns become dest's rows.  flip_x takes the columns from the
+ * right, flip_y reads each one from the bottom.  The copy goes a block at a
+ * time.
+ * \param source
+ * \param dest
+ * \param flip_x
+ * \param flip_y
+ */
+template <typename Pixel>
+static void transposePixels(const QImage& source, QImage* dest, bool flip_x, bool flip_y)
+{
+    int width = source.width();
+    int height = source.height();
+    const uchar* from_bits = source.constBits();
+    qint64 from_stride = source.bytesPerLine();
+    uchar* to_bits = dest->bits();
+    qint64 to_stride = dest->bytesPerLine();
+
+    // stepping along a dest row steps up or down a source column
+    const uchar* first_row = flip_y ? from_bits + (height - 1) * from_stride : from_bits;
+    qint64 step = flip_y ? -from_stride : from_stride;
+
+    for (int row_block = 0; row_block < width; row_block += TRANSPOSE_BLOCK) {
+        int row_end = qMin(row_block + TRANSPOSE_BLOCK, width);
+
+        for (int column_block = 0; column_block < height; column_block += TRANSPOSE_BLOCK) {
+            int column_end = qMin(column_block + TRANSPOSE_BLOCK, height);
+
+            for (int j = row_block; j < row_end; j++) {
+                int x = flip_x ? width - 1 - j : j;
+                const uchar* from = first_row + column_block * step + x * sizeof(Pixel);
+                Pixel* to = reinterpret_cast<Pixel*>(to_bits + j * to_stride);
+
+                for (int i = column_block; i < column_end; i++) {
+                    to[i] = *reinterpret_cast<const Pixel*>(from);
+                    from += step;
+                }
+            }
+        }
+    }
+}
+
+/*!
+ * \brief reorientPixels
+ * \param source
+ * \param dest
+ * \param transpose
+ * \param flip_x
+ * \param flip_y
+ */
+template <typename Pixel>
+static void reorientPixels(const QImage& source, QImage* dest, bool transpose,
+                           bool flip_x, bool flip_y)
+{
+    if (transpose)
+        transposePixels<Pixel>(source, dest, flip_x, flip_y);
+    else
+        flipPixels<Pixel>(source, dest, flip_x, flip_y);
+}
+
 /*!
  * \brief OrientationCorrection::fromOrientation
  * \param o
@@ -119,6 +229,95 @@ QTransform OrientationCorrection::toTransform() const
     return result;
 }
 
+/*!
+ * \brief OrientationCorrection::isIdentity
+ * \return true if the correction leaves an image as it is
+ */
+bool OrientationCorrection::isIdentity() const
+{
+    return m_rotationAngle == 0.0 && m_horizontalScaleFactor == 1.0;
+}
+
+/*!
+ * \brief OrientationCorrection::getPixelMapping
+ * Every correction is a quarter turn, half turn or none, then perhaps a
+ * horizontal mirror.  That comes down to whether the source's columns become
+ * rows, and which ends the source's rows and columns are read from.
+ * \param transpose set if the corrected image's rows are the source's columns
+ * \param flipX set if the source's columns are taken from the right
+ * \param flipY set if the source's rows are taken from the bottom
+ */
+void OrientationCorrection::getPixelMapping(bool* transpose, bool* flipX, bool* flipY) const
+{
+    bool mirrored = (m_horizontalScaleFactor < 0.0);
+
+    *transpose = (m_rotationAngle == 90.0 || m_rotationAngle == -90.0);
+    if (*transpose) {
+        *flipX = (m_rotationAngle == -90.0);
+        *flipY = (m_rotationAngle == 90.0) != mirrored;
+    } else {
+        *flipX = (m_rotationAngle == 180.0) != mirrored;
+        *flipY = (m_rotationAngle == 180.0);
+    }
+}
+
+/*!
+ * \brief OrientationCorrection::apply
+ * Returns the image with the correction applied, the same as transforming it
+ * by toTransform(), but moving the pixels directly rather than going through
+ * the general transformation.  An image that needs no correction is returned
+ * as it is, without a copy.
+ * \param image
+ * \return
+ */
+QImage OrientationCorrection::apply(const QImage& image) const
+{
+    if (isIdentity() || image.isNull())
+        return image;
+
+    bool transpose;
+    bool flip_x;
+    bool flip_y;
+    getPixelMapping(&transpose, &flip_x, &flip_y);
+
+    QImage result(transpose ? image.height() : image.width(),
+                  transpose ? image.width() : image.height(), image.format());
+    if (result.isNull())
+        return QImage();
+
+    switch (image.depth()) {
+    case 8:
+        reorientPixels<quint8>(image, &result, transpose, flip_x, flip_y);
+        break;
+
+    case 16:
+        reorientPixels<quint16>(image, &result, transpose, flip_x, flip_y);
+        break;
+
+    case 24:
+        reorientPixels<Pixel24>(image, &result, transpose, flip_x, flip_y);
+        break;
+
+    case 32:
+        reorientPixels<quint32>(image, &result, transpose, flip_x, flip_y);
+        break;
+
+    case 64:
+        reorientPixels<quint64>(image, &result, transpose, flip_x, flip_y);
+        break;
+
+    default:
+        // the packed one bit formats
+        return image.transformed(toTransform());
+    }
+
+    result.setColorTable(image.colorTable());
+    result.setDotsPerMeterX(transpose ? image.dotsPerMeterY() : image.dotsPerMeterX());
+    result.setDotsPerMeterY(transpose ? image.dotsPerMeterX() : image.dotsPerMeterY());
+
+    return result;
+}
+
 /*!
  * \brief OrientationCorrection::isFlippedFrom
  * Returns whether the two orientations are flipped relative to each other.
@@ -20,6 +20,7 @@
 #ifndef GALLERY_ORIENTATION_H_
 #define GALLERY_ORIENTATION_H_
 
+#include <QImage>
 #include <QTransform>
 
 enum Orientation {
@@ -46,6 +47,9 @@ public:
     static Orientation rotateOrientation(Orientation orientation, bool left);
 
     QTransform toTransform() const;
+    bool isIdentity() const;
+    void getPixelMapping(bool* transpose, bool* flipX, bool* flipY) const;
+    QImage apply(const QImage& image) const;
 
     bool isFlippedFrom(const OrientationCorrection& other) const;
     int getNormalizedRotationDifference(const OrientationCorrection& other) const;
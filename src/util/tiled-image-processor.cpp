@@ -0,0 +1,332 @@
+/*
+ * Copyright (C) 2014 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tiled-image-processor.h"
+#include "imaging.h"
+#include "jpeg-io.h"
+
+#include <QFile>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QSaveFile>
+
+#include <climits>
+
+const qint64 TiledImageProcessor::DEFAULT_MEMORY_BUDGET = 64 * 1024 * 1024;
+const int TiledImageProcessor::DEFAULT_QUALITY = 90;
+
+// A tile, and the copy of it a transformation may make
+static const int BYTES_PER_TILE_PIXEL = 2 * 4;
+
+/*!
+ * \brief TiledImageProcessor::TiledImageProcessor
+ * \param memoryBudget the most bytes of pixels to hold at once
+ */
+TiledImageProcessor::TiledImageProcessor(qint64 memoryBudget)
+    : m_memoryBudget(memoryBudget),
+      m_quality(DEFAULT_QUALITY)
+{
+}
+
+/*!
+ * \brief TiledImageProcessor::memoryBudget
+ * \return
+ */
+qint64 TiledImageProcessor::memoryBudget() const
+{
+    return m_memoryBudget;
+}
+
+/*!
+ * \brief TiledImageProcessor::setMemoryBudget
+ * \param memoryBudget
+ */
+void TiledImageProcessor::setMemoryBudget(qint64 memoryBudget)
+{
+    m_memoryBudget = memoryBudget;
+}
+
+/*!
+ * \brief TiledImageProcessor::quality
+ * \return
+ */
+int TiledImageProcessor::quality() const
+{
+    return m_quality;
+}
+
+/*!
+ * \brief TiledImageProcessor::setQuality
+ * \param quality the JPEG quality, from 0 to 100
+ */
+void TiledImageProcessor::setQuality(int quality)
+{
+    m_quality = qBound(0, quality, 100);
+}
+
+/*!
+ * \brief TiledImageProcessor::addTransformation
+ * Transformations are applied in the order they're added.  They're not owned
+ * by the processor.
+ * \param transformation
+ */
+void TiledImageProcessor::addTransformation(const TileTransformation* transformation)
+{
+    m_transformations.append(transformation);
+}
+
+/*!
+ * \brief TiledImageProcessor::tileHeight
+ * \param width
+ * \return how many scanlines of an image this wide fit the memory budget, at
+ * least one
+ */
+int TiledImageProcessor::tileHeight(int width) const
+{
+    qint64 lines = m_memoryBudget / ((qint64) qMax(width, 1) * BYTES_PER_TILE_PIXEL);
+
+    return (int) qBound((qint64) 1, lines, (qint64) INT_MAX);
+}
+
+/*!
+ * \brief TiledImageProcessor::process
+ * The destination is only replaced once the new image is complete, so it may
+ * be the source.
+ * \param sourcePath
+ * \param destPath
+ * \return false, with errorString() set, if the image couldn't be processed
+ */
+bool TiledImageProcessor::process(const QString& sourcePath, const QString& destPath)
+{
+    m_errorString.clear();
+
+    QFile source(sourcePath);
+    if (!source.open(QIODevice::ReadOnly)) {
+        m_errorString = source.errorString();
+        return false;
+    }
+
+    QSaveFile dest(destPath);
+    if (!dest.open(QIODevice::WriteOnly)) {
+        m_errorString = dest.errorString();
+        return false;
+    }
+
+    bool is_jpeg = source.peek(3) == QByteArray("\xFF\xD8\xFF");
+    bool processed = is_jpeg ? processJpeg(&source, &dest) : processWhole(&source, &dest);
+    if (!processed) {
+        dest.cancelWriting();
+        return false;
+    }
+
+    if (!dest.commit()) {
+        m_errorString = dest.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+/*!
+ * \brief TiledImageProcessor::errorString
+ * \return why the last process() failed
+ */
+const QString& TiledImageProcessor::errorString() const
+{
+    return m_errorString;
+}
+
+/*!
+ * \brief TiledImageProcessor::processJpeg
+ * Sets libjpeg up and catches its errors; the work is done by streamJpeg()
+ * \param source
+ * \param dest
+ * \return
+ */
+bool TiledImageProcessor::processJpeg(QIODevice* source, QIODevice* dest)
+{
+    // Everything that has to be cleaned up is made before the setjmp(), as a
+    // libjpeg error jumps straight back to it.
+    jpeg_decompress_struct decoder;
+    jpeg_compress_struct encoder;
+    JpegErrorManager error;
+    JpegSource input;
+    JpegDestination output;
+    QImage tile;
+    QByteArray row;
+
+    jpegSetErrorManager(&error, &decoder, &encoder);
+    jpeg_create_decompress(&decoder);
+    jpeg_create_compress(&encoder);
+    jpegSetSource(&decoder, &input, source);
+    jpegSetDestination(&encoder, &output, dest);
+
+    bool processed = false;
+    if (setjmp(error.jump) == 0) {
+        streamJpeg(&decoder, &encoder, &tile, &row);
+        processed = true;
+    } else if (m_errorString.isEmpty()) {
+        m_errorString = QString::fromLatin1(error.message);
+    }
+
+    jpeg_destroy_compress(&encoder);
+    jpeg_destroy_decompress(&decoder);
+
+    return processed;
+}
+
+/*!
+ * \brief TiledImageProcessor::streamJpeg
+ * Decodes a tile of scanlines, transforms it and encodes it, until the
+ * whole image is through.  The metadata (EXIF, colour profile, comments) is
+ * copied over as it is.  Nothing here may need destroying, as a libjpeg
+ * error jumps out of it.
+ * \param decoder
+ * \param encoder
+ * \param tile
+ * \param row
+ */
+void TiledImageProcessor::streamJpeg(jpeg_decompress_struct* decoder,
+                                     jpeg_compress_struct* encoder,
+                                     QImage* tile, QByteArray* row)
+{
+    jpegSaveMarkers(decoder);
+    jpeg_read_header(decoder, TRUE);
+
+    int width = decoder->image_width;
+    int height = decoder->image_height;
+
+    // libjpeg holds all of a progressive image's coefficients until the last
+    // scan is in
+    if (decoder->progressive_mode && (qint64) width * height *
+            decoder->num_components * sizeof(JCOEF) > m_memoryBudget) {
+        m_errorString = QString("Progressive JPEG is too large for the memory budget");
+        ERREXIT(decoder, JERR_OUT_OF_MEMORY);
+    }
+
+    decoder->out_color_space = JCS_RGB;
+    jpeg_start_decompress(decoder);
+
+    encoder->image_width = width;
+    encoder->image_height = height;
+    encoder->input_components = 3;
+    encoder->in_color_space = JCS_RGB;
+    jpeg_set_defaults(encoder);
+    jpeg_set_quality(encoder, m_quality, TRUE);
+    encoder->write_JFIF_header = decoder->saw_JFIF_marker;
+    jpeg_start_compress(encoder, TRUE);
+
+    jpegCopyMarkers(decoder, encoder);
+
+    int tile_height = qMin(tileHeight(width), height);
+    *tile = QImage(width, tile_height, QImage::Format_RGB32);
+    row->resize(width * 3);
+    JSAMPROW samples = reinterpret_cast<JSAMPROW>(row->data());
+
+    while ((int) decoder->output_scanline < height) {
+        int lines = qMin(tile_height, height - (int) decoder->output_scanline);
+        if (tile->width() != width || tile->height() != lines)
+            *tile = QImage(width, lines, QImage::Format_RGB32);
+
+        for (int j = 0; j < lines; j++) {
+            jpeg_read_scanlines(decoder, &samples, 1);
+
+            QRgb* pixels = reinterpret_cast<QRgb*>(tile->scanLine(j));
+            for (int i = 0; i < width; i++)
+                pixels[i] = qRgb(samples[3 * i], samples[3 * i + 1], samples[3 * i + 2]);
+        }
+
+        transform(tile);
+
+        for (int j = 0; j < lines; j++) {
+            const QRgb* pixels = reinterpret_cast<const QRgb*>(tile->constScanLine(j));
+            for (int i = 0; i < width; i++) {
+                samples[3 * i] = qRed(pixels[i]);
+                samples[3 * i + 1] = qGreen(pixels[i]);
+                samples[3 * i + 2] = qBlue(pixels[i]);
+            }
+
+            jpeg_write_scanlines(encoder, &samples, 1);
+        }
+    }
+
+    jpeg_finish_compress(encoder);
+    jpeg_finish_decompress(decoder);
+}
+
+/*!
+ * \brief TiledImageProcessor::processWhole
+ * For formats that can't be streamed, the image is taken as one tile, as
+ * long as it fits the budget, and written back in its own format, keeping
+ * any alpha channel
+ * \param source
+ * \param dest
+ * \return
+ */
+bool TiledImageProcessor::processWhole(QIODevice* source, QIODevice* dest)
+{
+    QImageReader reader(source);
+    QSize size = reader.size();
+    if (!size.isValid()) {
+        m_errorString = reader.errorString();
+        return false;
+    }
+
+    QByteArray format = reader.format();
+    if (!QImageWriter::supportedImageFormats().contains(format)) {
+        m_errorString = QString("Unable to write %1 images").arg(QString::fromLatin1(format));
+        return false;
+    }
+
+    if ((qint64) size.width() * size.height() * BYTES_PER_TILE_PIXEL > m_memoryBudget) {
+        m_errorString = QString("Image is too large for the memory budget");
+        return false;
+    }
+
+    QImage image = reader.read();
+    if (image.isNull()) {
+        m_errorString = reader.errorString();
+        return false;
+    }
+
+    image = image.convertToFormat(image.hasAlphaChannel()
+                                  ? QImage::Format_ARGB32 : QImage::Format_RGB32);
+    transform(&image);
+
+    // the quality setting is for JPEGs, the others keep their defaults
+    int quality = (format == "jpeg") ? m_quality : -1;
+    if (!image.save(dest, format.constData(), quality)) {
+        m_errorString = QString("Unable to encode the image");
+        return false;
+    }
+
+    return true;
+}
+
+/*!
+ * \brief TiledImageProcessor::transform
+ * \param tile
+ */
+void TiledImageProcessor::transform(QImage* tile) const
+{
+    foreach (const TileTransformation* transformation, m_transformations) {
+        transformation->transformTile(tile);
+
+        if (tile->format() != QImage::Format_RGB32 && tile->format() != QImage::Format_ARGB32)
+            *tile = tile->convertToFormat(tile->hasAlphaChannel()
+                                          ? QImage::Format_ARGB32 : QImage::Format_RGB32);
+    }
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2014 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GALLERY_UTIL_TILED_IMAGE_PROCESSOR_H_
+#define GALLERY_UTIL_TILED_IMAGE_PROCESSOR_H_
+
+#include <QByteArray>
+#include <QImage>
+#include <QList>
+#include <QString>
+
+class QIODevice;
+class TileTransformation;
+
+struct jpeg_compress_struct;
+struct jpeg_decompress_struct;
+
+/**
+  * Puts an image through a chain of transformations into a new file a tile
+  * (a band of whole scanlines) at a time, decoding, transforming and encoding
+  * each tile before the next one is read.  The tile height is picked to keep
+  * the pixels held at once within a memory budget, however large the image.
+  * JPEG images are streamed; other formats are read whole, so they're only
+  * taken on while they fit the budget, and are written back in the same
+  * format.
+  */
+class TiledImageProcessor
+{
+public:
+    static const qint64 DEFAULT_MEMORY_BUDGET;
+    static const int DEFAULT_QUALITY;
+
+    TiledImageProcessor(qint64 memoryBudget = DEFAULT_MEMORY_BUDGET);
+
+    qint64 memoryBudget() const;
+    void setMemoryBudget(qint64 memoryBudget);
+    int quality() const;
+    void setQuality(int quality);
+
+    void addTransformation(const TileTransformation* transformation);
+
+    int tileHeight(int width) const;
+
+    bool process(const QString& sourcePath, const QString& destPath);
+    const QString& errorString() const;
+
+private:
+    bool processJpeg(QIODevice* source, QIODevice* dest);
+    void streamJpeg(jpeg_decompress_struct* decoder, jpeg_compress_struct* encoder,
+                    QImage* tile, QByteArray* row);
+    bool processWhole(QIODevice* source, QIODevice* dest);
+    void transform(QImage* tile) const;
+
+    qint64 m_memoryBudget;
+    int m_quality;
+    QList<const TileTransformation*> m_transformations;
+    QString m_errorString;
+};
+
+#endif  // GALLERY_UTIL_TILED_IMAGE_PROCESSOR_H_
@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) 2014 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest/QtTest>
+#include <QElapsedTimer>
+
+#include <sys/resource.h>
+
+#include "imaging.h"
+#include "orientation.h"
+
+/*!
+ * Times the util/imaging hot loops over photo sized images. Besides the
+ * QBENCHMARK result each row prints its throughput, and the process's peak
+ * resident memory so far -- run one function at a time to see its own peak,
+ * for example: imaging-benchmark auto_enhance 48MP
+ */
+class tst_ImagingBenchmark : public QObject
+{
+  Q_OBJECT
+
+private slots:
+    void histogram_data();
+    void histogram();
+    void auto_enhance_data();
+    void auto_enhance();
+    void shadow_detail_data();
+    void shadow_detail();
+    void color_balance_data();
+    void color_balance();
+    void orientation_data();
+    void orientation();
+
+private:
+    void addSizes();
+};
+
+// Smooth gradients under some noise, like a photo. A cheap generator, so
+// making the 48MP image doesn't take longer than the benchmark itself.
+static QImage photoImage(int width, int height)
+{
+    QImage image(width, height, QImage::Format_RGB32);
+    quint32 seed = 42;
+    for (int j = 0; j < height; j++) {
+        QRgb* line = reinterpret_cast<QRgb*>(image.scanLine(j));
+        for (int i = 0; i < width; i++) {
+            seed = seed * 1664525u + 1013904223u;
+            int noise = seed >> 27;
+            line[i] = qRgb(i * 223 / width + noise, j * 223 / height + noise,
+                           (i + j) * 223 / (width + height) + noise);
+        }
+    }
+
+    return image;
+}
+
+static void report(const QImage& image, int passes, qint64 nsecs)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    double megapixels = image.width() * (double)image.height() / 1e6;
+    qDebug("%.1f MP/s, peak RSS %ld MB", megapixels * passes * 1e9 / qMax(nsecs, qint64(1)),
+           usage.ru_maxrss / 1024);
+}
+
+void tst_ImagingBenchmark::addSizes()
+{
+    QTest::addColumn<QSize>("size");
+
+    QTest::newRow("1MP") << QSize(1152, 864);
+    QTest::newRow("12MP") << QSize(4000, 3000);
+    QTest::newRow("48MP") << QSize(8000, 6000);
+}
+
+void tst_ImagingBenchmark::histogram_data()
+{
+    addSizes();
+}
+
+void tst_ImagingBenchmark::histogram()
+{
+    QFETCH(QSize, size);
+
+    QImage image = photoImage(size.width(), size.height());
+    float cumulative = 0.0f;
+
+    int passes = 0;
+    QElapsedTimer timer;
+    timer.start();
+    QBENCHMARK {
+        IntensityHistogram histogram(image);
+        cumulative = histogram.getCumulativeProbability(255);
+        passes++;
+    }
+    report(image, passes, timer.nsecsElapsed());
+
+    QVERIFY(qFuzzyCompare(cumulative, 1.0f));
+}
+
+void tst_ImagingBenchmark::auto_enhance_data()
+{
+    addSizes();
+}
+
+// The analysis of the reduced image and the pass over the full one, as
+// auto-enhancing a photo does it
+void tst_ImagingBenchmark::auto_enhance()
+{
+    QFETCH(QSize, size);
+
+    QImage image = photoImage(size.width(), size.height());
+    QImage result;
+
+    int passes = 0;
+    QElapsedTimer timer;
+    timer.start();
+    QBENCHMARK {
+        AutoEnhanceTransformation enhance(AutoEnhanceTransformation::analysisProxy(image));
+        result = enhance.apply(image);
+        passes++;
+    }
+    report(image, passes, timer.nsecsElapsed());
+
+    QCOMPARE(result.size(), image.size());
+}
+
+void tst_ImagingBenchmark::shadow_detail_data()
+{
+    addSizes();
+}
+
+void tst_ImagingBenchmark::shadow_detail()
+{
+    QFETCH(QSize, size);
+
+    QImage image = photoImage(size.width(), size.height());
+    ShadowDetailTransformation shadow(0.5f);
+
+    int passes = 0;
+    QElapsedTimer timer;
+    timer.start();
+    QBENCHMARK {
+        for (int j = 0; j < image.height(); j++) {
+            QRgb* line = reinterpret_cast<QRgb*>(image.scanLine(j));
+            for (int i = 0; i < image.width(); i++)
+                line[i] = shadow.transformPixel(QColor(line[i])).rgb();
+        }
+        passes++;
+    }
+    report(image, passes, timer.nsecsElapsed());
+}
+
+void tst_ImagingBenchmark::color_balance_data()
+{
+    addSizes();
+}
+
+void tst_ImagingBenchmark::color_balance()
+{
+    QFETCH(QSize, size);
+
+    QImage image = photoImage(size.width(), size.height());
+    ColorBalance balance(1.1, 1.2, 0.9, 10.0);
+
+    int passes = 0;
+    QElapsedTimer timer;
+    timer.start();
+    QBENCHMARK {
+        balance.apply(image);
+        passes++;
+    }
+    report(image, passes, timer.nsecsElapsed());
+}
+
+void tst_ImagingBenchmark::orientation_data()
+{
+    addSizes();
+}
+
+// A quarter turn, the costliest of the corrections
+void tst_ImagingBenchmark::orientation()
+{
+    QFETCH(QSize, size);
+
+    QImage image = photoImage(size.width(), size.height());
+    OrientationCorrection correction = OrientationCorrection::fromOrientation(RIGHT_TOP_ORIGIN);
+    QImage result;
+
+    int passes = 0;
+    QElapsedTimer timer;
+    timer.start();
+    QBENCHMARK {
+        result = correction.apply(image);
+        passes++;
+    }
+    report(image, passes, timer.nsecsElapsed());
+
+    QCOMPARE(result.size(), size.transposed());
+}
+
+QTEST_MAIN(tst_ImagingBenchmark);
+
+#include "tst_imaging_benchmark.moc"
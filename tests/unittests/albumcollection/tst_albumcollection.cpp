@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2014 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest/QtTest>
+
+#include "album.h"
+#include "album-collection.h"
+#include "album-default-template.h"
+#include "album-table.h"
+#include "media-collection.h"
+#include "media-source.h"
+#include "media-table.h"
+
+extern void addFakeAlbumMedia(qint64 albumId, qint64 mediaId);
+extern int fakeAlbumMediaCount(qint64 albumId);
+
+/*!
+ * Checks that an album reports the same number of media before it's loaded
+ * as after, and that media leaving the library leave unloaded albums
+ */
+class tst_AlbumCollection : public QObject
+{
+  Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+    void count_skips_missing_media();
+    void unloaded_album_forgets_removed_media();
+    void unload_keeps_count();
+
+private:
+    MediaSource* newMedia(qint64 id);
+
+    MediaTable* m_mediaTable;
+    MediaCollection* m_mediaCollection;
+    AlbumTable* m_albumTable;
+    AlbumDefaultTemplate* m_albumTemplate;
+};
+
+void tst_AlbumCollection::init()
+{
+    m_mediaTable = new MediaTable(0, 0);
+    m_mediaCollection = new MediaCollection(m_mediaTable);
+    m_albumTable = new AlbumTable(0);
+    m_albumTemplate = new AlbumDefaultTemplate();
+}
+
+void tst_AlbumCollection::cleanup()
+{
+    delete m_albumTemplate;
+    delete m_albumTable;
+    delete m_mediaCollection;
+    delete m_mediaTable;
+}
+
+MediaSource* tst_AlbumCollection::newMedia(qint64 id)
+{
+    MediaSource* media = new MediaSource();
+    media->setId(id);
+    m_mediaCollection->add(media);
+
+    return media;
+}
+
+void tst_AlbumCollection::count_skips_missing_media()
+{
+    newMedia(1);
+    newMedia(2);
+    addFakeAlbumMedia(10, 1);
+    addFakeAlbumMedia(10, 2);
+    // the file of media 3 is gone, so it never made it into the library
+    addFakeAlbumMedia(10, 3);
+
+    AlbumCollection albums(m_mediaCollection, m_albumTable, m_albumTemplate);
+    QCOMPARE(albums.count(), 1);
+    Album* album = albums.getAtAsType<Album*>(0);
+
+    QVERIFY(!album->isLoaded());
+    QCOMPARE(album->containedCount(), 2);
+
+    album->load();
+    QVERIFY(album->isLoaded());
+    QCOMPARE(album->containedCount(), 2);
+}
+
+void tst_AlbumCollection::unloaded_album_forgets_removed_media()
+{
+    MediaSource* removed = newMedia(1);
+    newMedia(2);
+    newMedia(3);
+    addFakeAlbumMedia(10, 1);
+    addFakeAlbumMedia(10, 2);
+    addFakeAlbumMedia(11, 1);
+    addFakeAlbumMedia(11, 3);
+
+    AlbumCollection albums(m_mediaCollection, m_albumTable, m_albumTemplate);
+    QCOMPARE(albums.count(), 2);
+
+    m_mediaCollection->remove(removed, true);
+
+    for (int i = 0; i < albums.count(); i++) {
+        Album* album = albums.getAtAsType<Album*>(i);
+        QVERIFY(!album->isLoaded());
+        QCOMPARE(album->containedCount(), 1);
+        QCOMPARE(fakeAlbumMediaCount(album->id()), 1);
+
+        album->load();
+        QCOMPARE(album->containedCount(), 1);
+    }
+}
+
+void tst_AlbumCollection::unload_keeps_count()
+{
+    newMedia(1);
+    newMedia(2);
+    newMedia(3);
+    addFakeAlbumMedia(10, 1);
+    addFakeAlbumMedia(10, 2);
+    addFakeAlbumMedia(10, 3);
+
+    AlbumCollection albums(m_mediaCollection, m_albumTable, m_albumTemplate);
+    Album* album = albums.getAtAsType<Album*>(0);
+    album->load();
+    QCOMPARE(album->containedCount(), 3);
+
+    albums.unloadClosedAlbums();
+    QVERIFY(!album->isLoaded());
+    QCOMPARE(album->containedCount(), 3);
+
+    album->load();
+    QVERIFY(album->isLoaded());
+    QCOMPARE(album->containedCount(), 3);
+}
+
+QTEST_MAIN(tst_AlbumCollection);
+
+#include "tst_albumcollection.moc"
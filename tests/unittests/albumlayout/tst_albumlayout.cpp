@@ -0,0 +1,236 @@
+/*
+ * Copyright (C) 2014 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest/QtTest>
+#include <QList>
+#include <QSize>
+
+#include "album-default-template.h"
+#include "album-layout.h"
+#include "media-source.h"
+
+typedef AlbumLayout::Page Page;
+
+/*!
+ * Checks the incremental AlbumLayout against laying all the media out again
+ * from scratch, and that the pages it reports as kept are the old ones
+ */
+class tst_AlbumLayout : public QObject
+{
+  Q_OBJECT
+
+private slots:
+    void cleanup();
+    void first_layout();
+    void keeps_tail();
+    void attach_detach();
+    void random_operations();
+
+private:
+    MediaSource* newMedia(bool portrait);
+    void update(AlbumLayout* layout, AlbumTemplate* albumTemplate,
+                const QList<MediaSource*>& media);
+
+    QList<MediaSource*> m_all;
+    // the media the incremental layout was last updated with
+    QList<MediaSource*> m_media;
+    AlbumLayout::Change m_change;
+    AlbumDefaultTemplate m_fullTemplate;
+};
+
+static bool samePage(const Page& a, const Page& b)
+{
+    return a.start == b.start && a.count == b.count && a.frames == b.frames
+            && a.fitState == b.fitState && a.templatePage->name() == b.templatePage->name();
+}
+
+MediaSource* tst_AlbumLayout::newMedia(bool portrait)
+{
+    MediaSource* media = new MediaSource();
+    media->setSize(portrait ? QSize(30, 40) : QSize(40, 30));
+    m_all.append(media);
+
+    return media;
+}
+
+void tst_AlbumLayout::update(AlbumLayout* layout, AlbumTemplate* albumTemplate,
+                             const QList<MediaSource*>& media)
+{
+    QList<Page> old_pages = layout->pages();
+    int shift = media.count() - m_media.count();
+    m_change = layout->update(albumTemplate, m_media, media);
+    m_media = media;
+    const QList<Page>& pages = layout->pages();
+
+    // the same as laying everything out again
+    AlbumLayout full;
+    full.update(&m_fullTemplate, QList<MediaSource*>(), media);
+
+    QCOMPARE(pages.count(), full.pages().count());
+    for (int i = 0; i < pages.count(); ++i)
+        QVERIFY2(samePage(pages[i], full.pages()[i]), qPrintable(QString("page %1").arg(i)));
+
+    QCOMPARE(pages.count() % 2, 0);
+    int next = 0;
+    foreach (const Page& page, pages) {
+        QCOMPARE(page.start, next);
+        next += page.count;
+    }
+    QCOMPARE(next, media.count());
+
+    // the pages before the first laid out and from the last one on are kept
+    int kept = old_pages.count() - m_change.reuseFrom;
+    QVERIFY(m_change.firstPage >= 0 && m_change.firstPage <= m_change.reuseFrom);
+    QCOMPARE(pages.count(), m_change.firstPage + m_change.laidOut + kept);
+
+    for (int i = 0; i < m_change.firstPage; ++i) {
+        QVERIFY(samePage(pages[i], old_pages[i]));
+        QCOMPARE(pages[i].templatePage, old_pages[i].templatePage);
+    }
+
+    for (int i = 0; i < kept; ++i) {
+        const Page& page = pages[m_change.firstPage + m_change.laidOut + i];
+        const Page& old_page = old_pages[m_change.reuseFrom + i];
+        QCOMPARE(page.templatePage, old_page.templatePage);
+        QCOMPARE(page.start, old_page.start + shift);
+        QCOMPARE(page.count, old_page.count);
+        QCOMPARE(page.fitState, old_page.fitState);
+        QCOMPARE((m_change.firstPage + m_change.laidOut) % 2, m_change.reuseFrom % 2);
+    }
+}
+
+void tst_AlbumLayout::cleanup()
+{
+    qDeleteAll(m_all);
+    m_all.clear();
+    m_media.clear();
+}
+
+void tst_AlbumLayout::first_layout()
+{
+    AlbumDefaultTemplate album_template;
+    AlbumLayout layout;
+
+    update(&layout, &album_template, QList<MediaSource*>());
+    QCOMPARE(layout.pages().count(), 0);
+    QCOMPARE(layout.populatedCount(), 0);
+
+    // a portrait page, a landscape pair, and a lone landscape with an empty
+    // page after it
+    QList<MediaSource*> media;
+    media << newMedia(true) << newMedia(false) << newMedia(false) << newMedia(false);
+    update(&layout, &album_template, media);
+    QCOMPARE(layout.pages().count(), 4);
+    QCOMPARE(layout.populatedCount(), 3);
+    QCOMPARE(layout.pages()[0].count, 1);
+    QCOMPARE(layout.pages()[1].count, 2);
+    QCOMPARE(layout.pages()[2].count, 1);
+    QCOMPARE(layout.pages()[3].count, 0);
+    QCOMPARE(m_change.firstPage, 0);
+    QCOMPARE(m_change.laidOut, 4);
+    QCOMPARE(m_change.reuseFrom, 0);
+
+    layout.clear();
+    QCOMPARE(layout.pages().count(), 0);
+}
+
+void tst_AlbumLayout::keeps_tail()
+{
+    AlbumDefaultTemplate album_template;
+    AlbumLayout layout;
+
+    QList<MediaSource*> media;
+    for (int i = 0; i < 20; ++i)
+        media << newMedia(false);
+    update(&layout, &album_template, media);
+    QCOMPARE(layout.pages().count(), 10);
+
+    // four more landscapes fill two pages, so the pages after them line up
+    // with the old ones on the same side
+    for (int i = 0; i < 4; ++i)
+        media.insert(10, newMedia(false));
+    update(&layout, &album_template, media);
+    QCOMPARE(m_change.firstPage, 5);
+    QCOMPARE(m_change.laidOut, 2);
+    QCOMPARE(m_change.reuseFrom, 5);
+    QCOMPARE(layout.pages().count(), 12);
+
+    // changing the end keeps everything before it
+    media.removeLast();
+    update(&layout, &album_template, media);
+    QCOMPARE(m_change.firstPage, 11);
+    QCOMPARE(m_change.reuseFrom, 12);
+}
+
+void tst_AlbumLayout::attach_detach()
+{
+    AlbumDefaultTemplate album_template;
+    AlbumLayout layout;
+
+    // landscape/portrait pairs make the template flip-flop
+    QList<MediaSource*> media;
+    for (int i = 0; i < 12; ++i)
+        media << newMedia(i % 3 == 1);
+    update(&layout, &album_template, media);
+
+    media.insert(0, newMedia(false));
+    update(&layout, &album_template, media);
+
+    media.insert(5, newMedia(true));
+    update(&layout, &album_template, media);
+
+    media.removeAt(3);
+    update(&layout, &album_template, media);
+
+    media.removeFirst();
+    update(&layout, &album_template, media);
+
+    media.clear();
+    update(&layout, &album_template, media);
+    QCOMPARE(layout.pages().count(), 0);
+}
+
+void tst_AlbumLayout::random_operations()
+{
+    qsrand(38);
+
+    AlbumDefaultTemplate album_template;
+    AlbumLayout layout;
+    QList<MediaSource*> media;
+
+    for (int step = 0; step < 1000; ++step) {
+        int operation = qrand() % 3;
+        int count = 1 + qrand() % 3;
+
+        if (operation < 2 || media.isEmpty()) {
+            int at = qrand() % (media.count() + 1);
+            for (int i = 0; i < count; ++i)
+                media.insert(at, newMedia(qrand() % 2 == 0));
+        } else {
+            int at = qrand() % media.count();
+            for (int i = 0; i < count && at < media.count(); ++i)
+                media.removeAt(at);
+        }
+
+        update(&layout, &album_template, media);
+        if (QTest::currentTestFailed())
+            return;
+    }
+}
+
+QTEST_MAIN(tst_AlbumLayout);
+
+#include "tst_albumlayout.moc"
@@ -0,0 +1,338 @@
+/*
+ * Copyright (C) 2014 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest/QtTest>
+#include <QVector>
+
+#include "bit-set.h"
+
+/*!
+ * Every test checks BitSet against a QVector<bool> holding the same bits,
+ * which is changed the obvious way a bit at a time
+ */
+class tst_BitSet : public QObject
+{
+  Q_OBJECT
+
+private slots:
+    void resize();
+    void set_range_data();
+    void set_range();
+    void runs();
+    void insert_ranges();
+    void remove_ranges();
+    void random_operations();
+};
+
+static void compare(const BitSet& bits, const QVector<bool>& model)
+{
+    QCOMPARE(bits.size(), model.count());
+    QCOMPARE(bits.count(), model.count(true));
+    for (int index = 0; index < model.count(); ++index)
+        QCOMPARE(bits.testBit(index), model[index]);
+}
+
+static QList<BitSet::Range> modelRuns(const QVector<bool>& model, int first, int last,
+                                      bool value)
+{
+    QList<BitSet::Range> runs;
+    for (int index = first; index <= last; ++index) {
+        if (model[index] != value)
+            continue;
+
+        if (!runs.isEmpty() && runs.last().second == index - 1)
+            runs.last().second = index;
+        else
+            runs.append(BitSet::Range(index, index));
+    }
+
+    return runs;
+}
+
+static QVector<bool> modelInsert(const QVector<bool>& model, const QList<BitSet::Range>& ranges)
+{
+    int inserted = 0;
+    foreach (const BitSet::Range& range, ranges)
+        inserted += range.second - range.first + 1;
+
+    QVector<bool> result;
+    int from = 0;
+    for (int index = 0; index < model.count() + inserted; ++index) {
+        bool opened = false;
+        foreach (const BitSet::Range& range, ranges)
+            opened = opened || (index >= range.first && index <= range.second);
+
+        result.append(opened ? false : model[from++]);
+    }
+
+    return result;
+}
+
+static QVector<bool> modelRemove(const QVector<bool>& model, const QList<BitSet::Range>& ranges)
+{
+    QVector<bool> result;
+    for (int index = 0; index < model.count(); ++index) {
+        bool closed = false;
+        foreach (const BitSet::Range& range, ranges)
+            closed = closed || (index >= range.first && index <= range.second);
+
+        if (!closed)
+            result.append(model[index]);
+    }
+
+    return result;
+}
+
+// Ascending, non-overlapping ranges somewhere between 0 and end
+static QList<BitSet::Range> randomRanges(int end)
+{
+    QList<BitSet::Range> ranges;
+    int next = qrand() % 80;
+    while (next < end && ranges.count() < 6) {
+        int last = qMin(end - 1, next + qrand() % 140);
+        ranges.append(BitSet::Range(next, last));
+        next = last + 2 + qrand() % 80;
+    }
+
+    return ranges;
+}
+
+void tst_BitSet::resize()
+{
+    BitSet bits;
+    QVector<bool> model;
+    compare(bits, model);
+
+    bits.resize(130);
+    model.fill(false, 130);
+    compare(bits, model);
+
+    bits.setRange(60, 129, true);
+    for (int index = 60; index < 130; ++index)
+        model[index] = true;
+    compare(bits, model);
+
+    // the bits dropped off the end don't come back when it grows again
+    bits.resize(70);
+    model.resize(70);
+    compare(bits, model);
+
+    bits.resize(200);
+    model.resize(200);
+    compare(bits, model);
+
+    bits.clear();
+    compare(bits, QVector<bool>());
+}
+
+void tst_BitSet::set_range_data()
+{
+    QTest::addColumn<int>("first");
+    QTest::addColumn<int>("last");
+
+    QTest::newRow("Single") << 5 << 5;
+    QTest::newRow("Within a word") << 3 << 40;
+    QTest::newRow("Word boundary") << 63 << 64;
+    QTest::newRow("Whole words") << 64 << 191;
+    QTest::newRow("Across words") << 10 << 250;
+    QTest::newRow("Everything") << 0 << 299;
+}
+
+void tst_BitSet::set_range()
+{
+    QFETCH(int, first);
+    QFETCH(int, last);
+
+    BitSet bits;
+    bits.resize(300);
+    QVector<bool> model(300, false);
+
+    // every other bit set beforehand, so only half the range changes
+    for (int index = 0; index < 300; index += 2) {
+        QVERIFY(bits.setBit(index, true));
+        model[index] = true;
+    }
+    QVERIFY(!bits.setBit(0, true));
+
+    int expected = 0;
+    for (int index = first; index <= last; ++index) {
+        expected += model[index] ? 0 : 1;
+        model[index] = true;
+    }
+
+    QCOMPARE(bits.setRange(first, last, true), expected);
+    compare(bits, model);
+    QCOMPARE(bits.count(first, last), last - first + 1);
+
+    expected = last - first + 1;
+    for (int index = first; index <= last; ++index)
+        model[index] = false;
+
+    QCOMPARE(bits.setRange(first, last, false), expected);
+    compare(bits, model);
+    QCOMPARE(bits.count(first, last), 0);
+}
+
+void tst_BitSet::runs()
+{
+    BitSet bits;
+    bits.resize(200);
+    QVector<bool> model(200, false);
+
+    int set[][2] = { { 0, 0 }, { 2, 63 }, { 64, 64 }, { 70, 127 }, { 199, 199 } };
+    for (int i = 0; i < 5; ++i) {
+        bits.setRange(set[i][0], set[i][1], true);
+        for (int index = set[i][0]; index <= set[i][1]; ++index)
+            model[index] = true;
+    }
+
+    int windows[][2] = { { 0, 199 }, { 1, 198 }, { 63, 64 }, { 65, 69 }, { 128, 198 }, { 5, 5 } };
+    for (int i = 0; i < 6; ++i) {
+        int first = windows[i][0];
+        int last = windows[i][1];
+        QCOMPARE(bits.runs(first, last, true), modelRuns(model, first, last, true));
+        QCOMPARE(bits.runs(first, last, false), modelRuns(model, first, last, false));
+    }
+}
+
+void tst_BitSet::insert_ranges()
+{
+    BitSet bits;
+    bits.resize(150);
+    bits.setRange(0, 149, true);
+    QVector<bool> model(150, true);
+
+    QList<BitSet::Range> ranges;
+    ranges << BitSet::Range(0, 1) << BitSet::Range(63, 65) << BitSet::Range(100, 227)
+           << BitSet::Range(283, 283);
+
+    bits.insertRanges(ranges);
+    model = modelInsert(model, ranges);
+    QCOMPARE(model.count(), 150 + 2 + 3 + 128 + 1);
+    compare(bits, model);
+
+    // nothing inserted leaves everything in place
+    bits.insertRanges(QList<BitSet::Range>());
+    compare(bits, model);
+}
+
+void tst_BitSet::remove_ranges()
+{
+    BitSet bits;
+    bits.resize(300);
+    QVector<bool> model(300, false);
+    for (int index = 0; index < 300; index += 3) {
+        bits.setBit(index, true);
+        model[index] = true;
+    }
+
+    // in any order
+    QList<BitSet::Range> ranges;
+    ranges << BitSet::Range(200, 299) << BitSet::Range(0, 0) << BitSet::Range(60, 130);
+
+    bits.removeRanges(ranges);
+    model = modelRemove(model, ranges);
+    QCOMPARE(model.count(), 300 - 100 - 1 - 71);
+    compare(bits, model);
+}
+
+void tst_BitSet::random_operations()
+{
+    qsrand(31);
+
+    BitSet bits;
+    QVector<bool> model;
+
+    for (int step = 0; step < 2000; ++step) {
+        switch (qrand() % 5) {
+        case 0: {
+            int size = qrand() % 700;
+            bits.resize(size);
+            model.resize(size);
+            break;
+        }
+        case 1: {
+            if (model.isEmpty())
+                break;
+
+            int first = qrand() % model.count();
+            int last = first + qrand() % (model.count() - first);
+            bool value = qrand() % 2;
+
+            int changed = 0;
+            for (int index = first; index <= last; ++index) {
+                changed += (model[index] != value) ? 1 : 0;
+                model[index] = value;
+            }
+            QCOMPARE(bits.setRange(first, last, value), changed);
+            break;
+        }
+        case 2: {
+            QList<BitSet::Range> ranges = randomRanges(model.count() + 200);
+            int inserted = 0;
+            for (int i = 0; i < ranges.count(); ++i) {
+                // positions after the insertion can't leave a gap past the end
+                int end = model.count() + inserted;
+                if (ranges[i].first > end) {
+                    ranges = ranges.mid(0, i);
+                    break;
+                }
+                inserted += ranges[i].second - ranges[i].first + 1;
+            }
+
+            bits.insertRanges(ranges);
+            model = modelInsert(model, ranges);
+            break;
+        }
+        case 3: {
+            if (model.isEmpty())
+                break;
+
+            QList<BitSet::Range> ranges = randomRanges(model.count());
+            if (ranges.count() > 1)
+                ranges.swap(0, ranges.count() - 1);
+
+            bits.removeRanges(ranges);
+            model = modelRemove(model, ranges);
+            break;
+        }
+        default: {
+            if (model.isEmpty())
+                break;
+
+            int first = qrand() % model.count();
+            int last = first + qrand() % (model.count() - first);
+            bool value = qrand() % 2;
+
+            QCOMPARE(bits.runs(first, last, value), modelRuns(model, first, last, value));
+
+            int expected = 0;
+            for (int index = first; index <= last; ++index)
+                expected += model[index] ? 1 : 0;
+            QCOMPARE(bits.count(first, last), expected);
+            break;
+        }
+        }
+
+        compare(bits, model);
+        if (QTest::currentTestFailed())
+            return;
+    }
+}
+
+QTEST_MAIN(tst_BitSet);
+
+#include "tst_bit-set.moc"
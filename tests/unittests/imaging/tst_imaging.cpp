@@ -15,9 +15,13 @@
  */
 
 #include <QtTest/QtTest>
+#include <QImageReader>
 #include <QString>
+#include <QTemporaryDir>
 
 #include "imaging.h"
+#include "orientation.h"
+#include "tiled-image-processor.h"
 
 class tst_Imaging : public QObject
 {
@@ -26,8 +30,54 @@ class tst_Imaging : public QObject
 private slots:
     void transform_pixel_data();
     void transform_pixel();
+    void color_balance_apply_data();
+    void color_balance_apply();
+    void histogram_data();
+    void histogram();
+    void histogram_benchmark_data();
+    void histogram_benchmark();
+    void remapped_histogram();
+    void auto_enhance_apply_data();
+    void auto_enhance_apply();
+    void auto_enhance_proxy_data();
+    void auto_enhance_proxy();
+    void read_analysis_proxy();
+    void orientation_apply_data();
+    void orientation_apply();
+    void tiled_jpeg();
+    void tiled_whole_image();
 };
 
+static QImage noiseImage(int width, int height, QImage::Format format)
+{
+    QImage image(width, height, QImage::Format_ARGB32);
+    qsrand(width * height);
+    for (int j = 0; j < height; j++) {
+        QRgb* line = reinterpret_cast<QRgb*>(image.scanLine(j));
+        for (int i = 0; i < width; i++)
+            line[i] = qRgba(qrand() % 256, qrand() % 256, qrand() % 256, qrand() % 256);
+    }
+
+    return image.convertToFormat(format);
+}
+
+// The histogram counted a pixel at a time, as it used to be
+static void pixelHistogram(const QImage& image, float* cumulative)
+{
+    int counts[256] = { 0 };
+    for (int j = 0; j < image.height(); j++) {
+        for (int i = 0; i < image.width(); i++)
+            counts[QColor(image.pixel(i, j)).value()]++;
+    }
+
+    float pixel_count = (float)(image.width() * image.height());
+    float accumulator = 0.0f;
+    for (int i = 0; i < 256; i++) {
+        accumulator += ((float) counts[i]) / pixel_count;
+        cumulative[i] = accumulator;
+    }
+}
+
 
 void tst_Imaging::transform_pixel_data()
 {
@@ -63,6 +113,307 @@ void tst_Imaging::transform_pixel()
     QCOMPARE(cb.transformPixel(color), result);
 }
 
+void tst_Imaging::color_balance_apply_data()
+{
+    transform_pixel_data();
+}
+
+void tst_Imaging::color_balance_apply()
+{
+    QFETCH(qreal, brightness);
+    QFETCH(qreal, contrast);
+    QFETCH(qreal, saturation);
+    QFETCH(qreal, hue);
+
+    ColorBalance cb(brightness, contrast, saturation, hue);
+    QImage image = noiseImage(1031, 769, QImage::Format_ARGB32);
+    QImage result = image;
+    cb.apply(result);
+
+    QCOMPARE(result.format(), QImage::Format_ARGB32);
+    for (int j = 0; j < image.height(); j += 7) {
+        for (int i = 0; i < image.width(); i += 3) {
+            QColor expected = cb.transformPixel(QColor(image.pixel(i, j)));
+            QRgb px = result.pixel(i, j);
+
+            QVERIFY(qAbs(qRed(px) - expected.red()) <= 1);
+            QVERIFY(qAbs(qGreen(px) - expected.green()) <= 1);
+            QVERIFY(qAbs(qBlue(px) - expected.blue()) <= 1);
+            QCOMPARE(qAlpha(px), qAlpha(image.pixel(i, j)));
+        }
+    }
+}
+
+void tst_Imaging::histogram_data()
+{
+    QTest::addColumn<QImage>("image");
+
+    QTest::newRow("RGB32") << noiseImage(67, 45, QImage::Format_RGB32);
+    QTest::newRow("ARGB32") << noiseImage(67, 45, QImage::Format_ARGB32);
+    QTest::newRow("ARGB32_Premultiplied") <<
+        noiseImage(67, 45, QImage::Format_ARGB32_Premultiplied);
+    QTest::newRow("RGB888") << noiseImage(67, 45, QImage::Format_RGB888);
+    QTest::newRow("Banded") << noiseImage(1031, 769, QImage::Format_RGB32);
+}
+
+void tst_Imaging::histogram()
+{
+    QFETCH(QImage, image);
+
+    float expected[256];
+    pixelHistogram(image, expected);
+
+    IntensityHistogram histogram(image);
+    for (int i = 0; i < 256; i++)
+        QCOMPARE(histogram.getCumulativeProbability(i), expected[i]);
+}
+
+void tst_Imaging::histogram_benchmark_data()
+{
+    QTest::addColumn<bool>("scanline");
+
+    QTest::newRow("Scanline") << true;
+    QTest::newRow("Pixel") << false;
+}
+
+void tst_Imaging::histogram_benchmark()
+{
+    QFETCH(bool, scanline);
+
+    QImage image = noiseImage(2048, 1536, QImage::Format_RGB32);
+    float cumulative[256];
+
+    if (scanline) {
+        QBENCHMARK {
+            IntensityHistogram histogram(image);
+            cumulative[255] = histogram.getCumulativeProbability(255);
+        }
+    } else {
+        QBENCHMARK {
+            pixelHistogram(image, cumulative);
+        }
+    }
+
+    QVERIFY(qFuzzyCompare(cumulative[255], 1.0f));
+}
+
+void tst_Imaging::remapped_histogram()
+{
+    QImage image = noiseImage(67, 45, QImage::Format_RGB32);
+    ShadowDetailTransformation shadow(0.3f);
+
+    QImage shadow_corrected_image(image);
+    for (int j = 0; j < image.height(); j++) {
+        for (int i = 0; i < image.width(); i++) {
+            QColor px = shadow.transformPixel(QColor(image.pixel(i, j)));
+            shadow_corrected_image.setPixel(i, j, px.rgb());
+        }
+    }
+
+    IntensityHistogram expected(shadow_corrected_image);
+    IntensityHistogram basis(image);
+    IntensityHistogram histogram(basis, shadow);
+    for (int i = 0; i < 256; i++)
+        QCOMPARE(histogram.getCumulativeProbability(i), expected.getCumulativeProbability(i));
+}
+
+void tst_Imaging::auto_enhance_apply_data()
+{
+    QTest::addColumn<QImage>("image");
+
+    // a dark image gets shadow detail as well as tone expansion
+    QImage dark = noiseImage(67, 45, QImage::Format_RGB32);
+    for (int j = 0; j < dark.height(); j++) {
+        for (int i = 0; i < dark.width(); i++) {
+            QRgb px = dark.pixel(i, j);
+            dark.setPixel(i, j, qRgb(qRed(px) / 4, qGreen(px) / 4, qBlue(px) / 4));
+        }
+    }
+
+    QTest::newRow("Noise") << noiseImage(67, 45, QImage::Format_RGB32);
+    QTest::newRow("Dark") << dark;
+    QTest::newRow("ARGB32") << noiseImage(67, 45, QImage::Format_ARGB32);
+    QTest::newRow("Banded") << noiseImage(1031, 769, QImage::Format_RGB32);
+}
+
+void tst_Imaging::auto_enhance_apply()
+{
+    QFETCH(QImage, image);
+
+    AutoEnhanceTransformation enhance(image);
+    QImage result = enhance.apply(image);
+    QCOMPARE(result.size(), image.size());
+
+    // apply() keeps the hue that transformPixel() rounds to whole degrees, so
+    // only the value has to match exactly
+    for (int j = 0; j < image.height(); j += 7) {
+        for (int i = 0; i < image.width(); i += 3) {
+            QColor expected = enhance.transformPixel(QColor(image.pixel(i, j)));
+            QColor px(result.pixel(i, j));
+
+            QCOMPARE(px.value(), expected.value());
+            QVERIFY(qAbs(px.red() - expected.red()) <= 6);
+            QVERIFY(qAbs(px.green() - expected.green()) <= 6);
+            QVERIFY(qAbs(px.blue() - expected.blue()) <= 6);
+            QCOMPARE(qAlpha(result.pixel(i, j)), qAlpha(image.pixel(i, j)));
+        }
+    }
+}
+
+void tst_Imaging::auto_enhance_proxy_data()
+{
+    QTest::addColumn<int>("divisor");
+
+    QTest::newRow("Bright") << 1;
+    QTest::newRow("Dark") << 4;
+}
+
+void tst_Imaging::auto_enhance_proxy()
+{
+    QFETCH(int, divisor);
+
+    // smooth gradients under some noise, like a photo
+    QImage image(2592, 1944, QImage::Format_RGB32);
+    qsrand(42);
+    for (int j = 0; j < image.height(); j++) {
+        QRgb* line = reinterpret_cast<QRgb*>(image.scanLine(j));
+        for (int i = 0; i < image.width(); i++) {
+            int noise = qrand() % 32;
+            line[i] = qRgb((i * 223 / image.width() + noise) / divisor,
+                           (j * 223 / image.height() + noise) / divisor,
+                           ((i + j) * 223 / (image.width() + image.height()) + noise) / divisor);
+        }
+    }
+
+    QImage proxy = AutoEnhanceTransformation::analysisProxy(image);
+    QVERIFY(proxy.width() * proxy.height() <= AutoEnhanceTransformation::MAX_ANALYSIS_PIXELS);
+
+    AutoEnhanceTransformation full(image);
+    AutoEnhanceTransformation scaled(proxy);
+    QVERIFY(qAbs(full.lowKink() - scaled.lowKink()) <= 2);
+    QVERIFY(qAbs(full.highKink() - scaled.highKink()) <= 2);
+}
+
+void tst_Imaging::read_analysis_proxy()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    QString path = dir.path() + "/large.png";
+    QVERIFY(noiseImage(1600, 1200, QImage::Format_RGB32).save(path));
+
+    QImage proxy = AutoEnhanceTransformation::readAnalysisProxy(path);
+    QVERIFY(proxy.width() * proxy.height() <= AutoEnhanceTransformation::MAX_ANALYSIS_PIXELS);
+    QVERIFY(qAbs(proxy.width() * 3 - proxy.height() * 4) <= 4);
+
+    QVERIFY(AutoEnhanceTransformation::readAnalysisProxy(dir.path() + "/missing.png").isNull());
+}
+
+void tst_Imaging::orientation_apply_data()
+{
+    QTest::addColumn<int>("orientation");
+    QTest::addColumn<int>("format");
+
+    for (int o = MIN_ORIENTATION; o <= MAX_ORIENTATION; o++) {
+        QTest::newRow(qPrintable(QString("rgb32 %1").arg(o))) << o << (int) QImage::Format_RGB32;
+        QTest::newRow(qPrintable(QString("rgb888 %1").arg(o))) << o << (int) QImage::Format_RGB888;
+        QTest::newRow(qPrintable(QString("indexed8 %1").arg(o))) << o << (int) QImage::Format_Indexed8;
+    }
+}
+
+void tst_Imaging::orientation_apply()
+{
+    QFETCH(int, orientation);
+    QFETCH(int, format);
+
+    OrientationCorrection correction =
+            OrientationCorrection::fromOrientation(static_cast<Orientation>(orientation));
+    QImage image = noiseImage(101, 67, QImage::Format_RGB32)
+            .convertToFormat(static_cast<QImage::Format>(format));
+
+    QImage result = correction.apply(image);
+    QImage expected = image.transformed(correction.toTransform());
+
+    QCOMPARE(result.format(), image.format());
+    QCOMPARE(result.size(), expected.size());
+    for (int j = 0; j < result.height(); j++) {
+        for (int i = 0; i < result.width(); i++)
+            QCOMPARE(result.pixel(i, j), expected.pixel(i, j));
+    }
+
+    if (orientation == TOP_LEFT_ORIGIN)
+        QCOMPARE(result.constBits(), image.constBits());
+}
+
+void tst_Imaging::tiled_jpeg()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    QString source = dir.path() + "/source.jpg";
+    QVERIFY(noiseImage(1031, 769, QImage::Format_RGB32).save(source, "jpeg", 95));
+
+    ColorBalance cb(1.2, 0.9, 1.1, 10.0);
+
+    // a few scanlines at a time, and the whole image at once
+    TiledImageProcessor tiled(1031 * 8 * 5);
+    tiled.addTransformation(&cb);
+    QCOMPARE(tiled.tileHeight(1031), 5);
+    QVERIFY(tiled.process(source, dir.path() + "/tiled.jpg"));
+
+    TiledImageProcessor whole(1031 * 8 * 1000);
+    whole.addTransformation(&cb);
+    QVERIFY(whole.process(source, dir.path() + "/whole.jpg"));
+
+    QFile tiled_file(dir.path() + "/tiled.jpg");
+    QFile whole_file(dir.path() + "/whole.jpg");
+    QVERIFY(tiled_file.open(QIODevice::ReadOnly));
+    QVERIFY(whole_file.open(QIODevice::ReadOnly));
+    QCOMPARE(tiled_file.readAll(), whole_file.readAll());
+
+    QImage result(dir.path() + "/tiled.jpg");
+    QCOMPARE(result.size(), QSize(1031, 769));
+
+    // editing in place replaces the source
+    QVERIFY(tiled.process(source, source));
+    QCOMPARE(QImage(source).size(), QSize(1031, 769));
+}
+
+void tst_Imaging::tiled_whole_image()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    QString source = dir.path() + "/source.png";
+    QVERIFY(noiseImage(320, 240, QImage::Format_ARGB32).save(source));
+
+    ColorBalance cb(1.2, 0.9, 1.1, 10.0);
+    TiledImageProcessor processor;
+    processor.addTransformation(&cb);
+    QVERIFY(processor.process(source, dir.path() + "/edited.png"));
+
+    // written in the source's format, with its alpha channel
+    QImageReader reader(dir.path() + "/edited.png");
+    QCOMPARE(reader.format(), QByteArray("png"));
+    QImage edited = reader.read();
+    QCOMPARE(edited.size(), QSize(320, 240));
+    QVERIFY(edited.hasAlphaChannel());
+    QCOMPARE(qAlpha(edited.pixel(10, 10)), qAlpha(QImage(source).pixel(10, 10)));
+
+    // editing in place keeps the format too
+    QVERIFY(processor.process(source, source));
+    QImageReader in_place(source);
+    QCOMPARE(in_place.format(), QByteArray("png"));
+
+    // a format that can't be streamed has to fit the budget in one piece
+    processor.setMemoryBudget(320 * 8 * 100);
+    QVERIFY(!processor.process(source, dir.path() + "/too-large.jpg"));
+    QVERIFY(!processor.errorString().isEmpty());
+    QVERIFY(!QFile::exists(dir.path() + "/too-large.jpg"));
+
+    QVERIFY(!processor.process(dir.path() + "/missing.png", dir.path() + "/missing.jpg"));
+}
+
 QTEST_MAIN(tst_Imaging);
 
 #include "tst_imaging.moc"
@@ -15,8 +15,10 @@
  */
 
 #include <QtTest/QtTest>
+#include <QTemporaryDir>
 
 #include "photo/photo-metadata.h"
+#include "util/jpeg-orientation.h"
 
 class tst_PhotoMetadata : public QObject
 {
@@ -24,6 +26,11 @@ class tst_PhotoMetadata : public QObject
 
 private slots:
     void exposureTime();
+    void saveOrientation();
+    void saveTwice();
+    void updateThumbnail();
+    void transformLossless();
+    void malformedExif();
 
 private:
     PhotoMetadata *m_metadata;
@@ -41,6 +48,139 @@ void tst_PhotoMetadata::exposureTime()
     QCOMPARE(m_metadata->exposureTime(), QDateTime(QDate(2015, 12, 31), QTime(23, 59, 59)));
 }
 
+void tst_PhotoMetadata::saveOrientation()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString path = dir.path() + "/sample01.jpg";
+    QVERIFY(QFile::copy(SAMPLE_IMAGE_DIR "/sample01.jpg", path));
+    QFile::setPermissions(path, QFile::ReadOwner | QFile::WriteOwner);
+
+    // The sample has no orientation yet, so it has to be added by Exiv2
+    QVERIFY(!JpegOrientation::patchOrientation(path, RIGHT_TOP_ORIGIN));
+    m_metadata = PhotoMetadata::fromFile(path.toUtf8().constData());
+    m_metadata->setOrientation(RIGHT_TOP_ORIGIN);
+    QVERIFY(m_metadata->save());
+    delete m_metadata;
+    QCOMPARE(JpegOrientation::readOrientation(path), RIGHT_TOP_ORIGIN);
+
+    // after which it's changed in place
+    qint64 size = QFileInfo(path).size();
+    m_metadata = PhotoMetadata::fromFile(path.toUtf8().constData());
+    m_metadata->setOrientation(BOTTOM_RIGHT_ORIGIN);
+    QVERIFY(m_metadata->save());
+    delete m_metadata;
+    QCOMPARE(QFileInfo(path).size(), size);
+    QCOMPARE(JpegOrientation::readOrientation(path), BOTTOM_RIGHT_ORIGIN);
+
+    m_metadata = PhotoMetadata::fromFile(path.toUtf8().constData());
+    QCOMPARE(m_metadata->orientation(), BOTTOM_RIGHT_ORIGIN);
+    delete m_metadata;
+}
+
+void tst_PhotoMetadata::saveTwice()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString path = dir.path() + "/sample01.jpg";
+    QVERIFY(QFile::copy(SAMPLE_IMAGE_DIR "/sample01.jpg", path));
+    QFile::setPermissions(path, QFile::ReadOwner | QFile::WriteOwner);
+
+    m_metadata = PhotoMetadata::fromFile(path.toUtf8().constData());
+    m_metadata->setOrientation(RIGHT_TOP_ORIGIN);
+    m_metadata->setDateTimeDigitized(QDateTime(QDate(2015, 12, 31), QTime(23, 59, 59)));
+    QVERIFY(m_metadata->save());
+
+    // Tag the file behind the metadata's back; it only survives the second
+    // save if that patches the orientation rather than rewriting everything
+    Exiv2::Image::AutoPtr image = Exiv2::ImageFactory::open(path.toStdString());
+    image->readMetadata();
+    image->exifData()["Exif.Image.Artist"] = "tst_photo-metadata";
+    image->writeMetadata();
+
+    m_metadata->setOrientation(BOTTOM_RIGHT_ORIGIN);
+    QVERIFY(m_metadata->save());
+    delete m_metadata;
+    QCOMPARE(JpegOrientation::readOrientation(path), BOTTOM_RIGHT_ORIGIN);
+
+    image = Exiv2::ImageFactory::open(path.toStdString());
+    image->readMetadata();
+    QVERIFY(image->exifData().findKey(Exiv2::ExifKey("Exif.Image.Artist")) !=
+            image->exifData().end());
+
+    m_metadata = PhotoMetadata::fromFile(path.toUtf8().constData());
+    QCOMPARE(m_metadata->exposureTime(), QDateTime(QDate(2015, 12, 31), QTime(23, 59, 59)));
+    delete m_metadata;
+}
+
+void tst_PhotoMetadata::updateThumbnail()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString path = dir.path() + "/sample01.jpg";
+    QVERIFY(QFile::copy(SAMPLE_IMAGE_DIR "/sample01.jpg", path));
+    QFile::setPermissions(path, QFile::ReadOwner | QFile::WriteOwner);
+
+    m_metadata = PhotoMetadata::fromFile(path.toUtf8().constData());
+    QVERIFY(m_metadata->updateThumbnail());
+    QVERIFY(m_metadata->save());
+    delete m_metadata;
+
+    // the sample is 1836x3264
+    Exiv2::Image::AutoPtr image = Exiv2::ImageFactory::open(path.toStdString());
+    image->readMetadata();
+    Exiv2::ExifThumbC thumb(image->exifData());
+    Exiv2::DataBuf data = thumb.copy();
+    QImage thumbnail = QImage::fromData(data.pData_, data.size_, "jpeg");
+    QCOMPARE(thumbnail.size(), QSize(216, 384));
+}
+
+void tst_PhotoMetadata::transformLossless()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString path = dir.path() + "/sample01.jpg";
+    QVERIFY(QFile::copy(SAMPLE_IMAGE_DIR "/sample01.jpg", path));
+    QFile::setPermissions(path, QFile::ReadOwner | QFile::WriteOwner);
+
+    m_metadata = PhotoMetadata::fromFile(path.toUtf8().constData());
+    m_metadata->setOrientation(RIGHT_TOP_ORIGIN);
+    QVERIFY(m_metadata->save());
+    delete m_metadata;
+
+    QString upright = dir.path() + "/upright.jpg";
+    QVERIFY(JpegOrientation::transformLossless(path, upright, RIGHT_TOP_ORIGIN));
+    QCOMPARE(QImage(upright).size(), QSize(3264, 1836));
+    QCOMPARE(JpegOrientation::readOrientation(upright), TOP_LEFT_ORIGIN);
+
+    // a horizontal flip trims the partial column of MCUs on the right
+    QString flipped = dir.path() + "/flipped.jpg";
+    QVERIFY(JpegOrientation::transformLossless(path, flipped, TOP_RIGHT_ORIGIN));
+    QCOMPARE(QImage(flipped).size(), QSize(1824, 3264));
+
+    QVERIFY(!JpegOrientation::transformLossless(dir.path() + "/missing.jpg", flipped,
+                                                RIGHT_TOP_ORIGIN));
+}
+
+void tst_PhotoMetadata::malformedExif()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString path = dir.path() + "/malformed.jpg";
+
+    // an IFD offset of 0xFFFFFFFF, which wraps to 1 if two is added in 32 bits
+    const char exif[] = "\xFF\xD8\xFF\xE1\x00\x18" "Exif\0\0" "MM\0\x2A"
+                        "\xFF\xFF\xFF\xFF" "\x00\x01\x01\x12\x00\x03\x00\x00"
+                        "\xFF\xD9";
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(exif, sizeof(exif) - 1);
+    file.close();
+
+    QCOMPARE(JpegOrientation::readOrientation(path), TOP_LEFT_ORIGIN);
+    QVERIFY(!JpegOrientation::patchOrientation(path, RIGHT_TOP_ORIGIN));
+}
+
 QTEST_MAIN(tst_PhotoMetadata);
 
 #include "tst_photo-metadata.moc"
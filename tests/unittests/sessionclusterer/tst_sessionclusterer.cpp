@@ -0,0 +1,388 @@
+/*
+ * Copyright (C) 2014 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest/QtTest>
+#include <QDateTime>
+#include <QList>
+
+#include <algorithm>
+#include <limits>
+
+#include "media-source.h"
+#include "session-clusterer.h"
+
+typedef SessionClusterer::Session Session;
+
+/*!
+ * Checks the incremental SessionClusterer against grouping all the media
+ * again from scratch, and checks that replaying the changes it reports on
+ * the previous sessions gives the current ones, as QmlSessionCollectionModel
+ * does
+ */
+class tst_SessionClusterer : public QObject
+{
+  Q_OBJECT
+
+private slots:
+    void cleanup();
+    void insert();
+    void remove();
+    void remove_splits();
+    void update();
+    void set_gap();
+    void unset_exposure();
+    void random_operations();
+
+private:
+    MediaSource* newMedia(qint64 msecs);
+    void setExposure(MediaSource* media, qint64 msecs);
+    QList<Session> regroup(qint64 gap) const;
+    void check(SessionClusterer* clusterer);
+
+    QList<MediaSource*> m_all;
+    // the media held by the clusterer
+    QList<MediaSource*> m_media;
+    // the sessions as last seen through the reported changes
+    QList<Session> m_view;
+};
+
+static bool mediaLessThan(const MediaSource* a, const MediaSource* b)
+{
+    return (a->exposureMSecs() != b->exposureMSecs()) ? a->exposureMSecs() < b->exposureMSecs()
+                                                      : a->number() < b->number();
+}
+
+static bool sessionLessThan(const Session& a, const Session& b)
+{
+    return (a.startMSecs != b.startMSecs) ? a.startMSecs < b.startMSecs
+                                          : a.startNumber < b.startNumber;
+}
+
+static bool sameSessions(const QList<Session>& a, const QList<Session>& b)
+{
+    if (a.count() != b.count())
+        return false;
+
+    for (int i = 0; i < a.count(); ++i) {
+        if (a[i].startMSecs != b[i].startMSecs || a[i].endMSecs != b[i].endMSecs
+                || a[i].count != b[i].count || a[i].startNumber != b[i].startNumber)
+            return false;
+    }
+
+    return true;
+}
+
+static int findSession(const QList<Session>& sessions, const Session& session)
+{
+    for (int i = 0; i < sessions.count(); ++i) {
+        if (sessions[i].startMSecs == session.startMSecs
+                && sessions[i].startNumber == session.startNumber)
+            return i;
+    }
+
+    return -1;
+}
+
+MediaSource* tst_SessionClusterer::newMedia(qint64 msecs)
+{
+    MediaSource* media = new MediaSource();
+    setExposure(media, msecs);
+    m_all.append(media);
+
+    return media;
+}
+
+void tst_SessionClusterer::setExposure(MediaSource* media, qint64 msecs)
+{
+    media->setExposureDateTime(QDateTime::fromMSecsSinceEpoch(msecs));
+}
+
+// the sessions worked out from scratch, with times that cannot overflow
+QList<Session> tst_SessionClusterer::regroup(qint64 gap) const
+{
+    QList<MediaSource*> sorted = m_media;
+    std::sort(sorted.begin(), sorted.end(), mediaLessThan);
+
+    QList<Session> sessions;
+    foreach (MediaSource* media, sorted) {
+        if (!sessions.isEmpty() && media->exposureMSecs() - sessions.last().endMSecs <= gap) {
+            sessions.last().endMSecs = media->exposureMSecs();
+            sessions.last().count++;
+        } else {
+            Session session = { media->exposureMSecs(), media->exposureMSecs(), 1, media->number() };
+            sessions.append(session);
+        }
+    }
+
+    return sessions;
+}
+
+void tst_SessionClusterer::check(SessionClusterer* clusterer)
+{
+    SessionClusterer::Changes changes = clusterer->takeChanges();
+
+    foreach (const Session& session, changes.removed) {
+        int at = findSession(m_view, session);
+        QVERIFY(at >= 0);
+        m_view.removeAt(at);
+    }
+
+    foreach (const Session& session, changes.changed) {
+        int at = findSession(m_view, session);
+        QVERIFY(at >= 0);
+        m_view[at] = session;
+    }
+
+    foreach (const Session& session, changes.added) {
+        QCOMPARE(findSession(m_view, session), -1);
+        m_view.insert(std::lower_bound(m_view.begin(), m_view.end(), session, sessionLessThan)
+                      - m_view.begin(), session);
+    }
+
+    QList<Session> expected = regroup(clusterer->gap());
+    QVERIFY(sameSessions(clusterer->sessions(), expected));
+    QVERIFY(sameSessions(m_view, expected));
+    QCOMPARE(clusterer->sessionCount(), expected.count());
+    QCOMPARE(clusterer->mediaCount(), m_media.count());
+}
+
+void tst_SessionClusterer::cleanup()
+{
+    qDeleteAll(m_all);
+    m_all.clear();
+    m_media.clear();
+    m_view.clear();
+}
+
+void tst_SessionClusterer::insert()
+{
+    SessionClusterer clusterer(10);
+
+    // out of order, bridging and extending sessions at both ends
+    qint64 times[] = { 100, 200, 105, 190, 150, 100, 300, 90, 210, 160, 140, 130, 120, 170, 180 };
+    for (unsigned i = 0; i < sizeof(times) / sizeof(times[0]); ++i) {
+        MediaSource* media = newMedia(times[i]);
+        QVERIFY(clusterer.insert(media));
+        m_media.append(media);
+        check(&clusterer);
+    }
+
+    QVERIFY(!clusterer.insert(m_media.first()));
+    QCOMPARE(clusterer.sessionCount(), 3);
+
+    // joining a session only changes that session
+    MediaSource* media = newMedia(185);
+    clusterer.insert(media);
+    m_media.append(media);
+    SessionClusterer::Changes changes = clusterer.takeChanges();
+    QCOMPARE(changes.removed.count(), 0);
+    QCOMPARE(changes.changed.count(), 1);
+    QCOMPARE(changes.added.count(), 0);
+    QCOMPARE(changes.changed.first().count, 11);
+}
+
+void tst_SessionClusterer::remove()
+{
+    SessionClusterer clusterer(10);
+
+    qint64 times[] = { 10, 20, 30, 100, 200, 205, 210 };
+    for (unsigned i = 0; i < sizeof(times) / sizeof(times[0]); ++i) {
+        m_media.append(newMedia(times[i]));
+        clusterer.insert(m_media.last());
+    }
+    check(&clusterer);
+
+    // the first, the last, a lone media and one from the middle
+    int order[] = { 0, 6, 3, 4, 1 };
+    for (unsigned i = 0; i < sizeof(order) / sizeof(order[0]); ++i) {
+        MediaSource* media = m_all[order[i]];
+        QVERIFY(clusterer.remove(media));
+        m_media.removeOne(media);
+        check(&clusterer);
+    }
+
+    QVERIFY(!clusterer.remove(m_all[0]));
+
+    foreach (MediaSource* media, m_media)
+        clusterer.remove(media);
+    m_media.clear();
+    check(&clusterer);
+    QCOMPARE(clusterer.sessionCount(), 0);
+}
+
+void tst_SessionClusterer::remove_splits()
+{
+    SessionClusterer clusterer(10);
+
+    qint64 times[] = { 0, 10, 20, 30, 40, 50 };
+    for (unsigned i = 0; i < sizeof(times) / sizeof(times[0]); ++i) {
+        m_media.append(newMedia(times[i]));
+        clusterer.insert(m_media.last());
+    }
+    check(&clusterer);
+    QCOMPARE(clusterer.sessionCount(), 1);
+
+    clusterer.remove(m_all[2]);
+    m_media.removeOne(m_all[2]);
+
+    SessionClusterer::Changes changes = clusterer.takeChanges();
+    QCOMPARE(changes.removed.count(), 0);
+    QCOMPARE(changes.changed.count(), 1);
+    QCOMPARE(changes.changed.first().count, 2);
+    QCOMPARE(changes.changed.first().endMSecs, qint64(10));
+    QCOMPARE(changes.added.count(), 1);
+    QCOMPARE(changes.added.first().startMSecs, qint64(30));
+    QCOMPARE(changes.added.first().count, 3);
+
+    QList<Session> expected = regroup(clusterer.gap());
+    QVERIFY(sameSessions(clusterer.sessions(), expected));
+
+    // putting it back joins them again, whatever happened in between
+    clusterer.insert(m_all[2]);
+    clusterer.remove(m_all[2]);
+    clusterer.insert(m_all[2]);
+    m_media.append(m_all[2]);
+    changes = clusterer.takeChanges();
+    QCOMPARE(changes.removed.count(), 1);
+    QCOMPARE(changes.changed.count(), 1);
+    QCOMPARE(changes.added.count(), 0);
+    QCOMPARE(clusterer.sessionCount(), 1);
+
+    QVERIFY(!clusterer.insert(m_all[2]));
+    QCOMPARE(clusterer.takeChanges().changed.count(), 0);
+}
+
+void tst_SessionClusterer::update()
+{
+    SessionClusterer clusterer(10);
+
+    qint64 times[] = { 0, 5, 10, 100, 105, 200 };
+    for (unsigned i = 0; i < sizeof(times) / sizeof(times[0]); ++i) {
+        m_media.append(newMedia(times[i]));
+        clusterer.insert(m_media.last());
+    }
+    check(&clusterer);
+
+    QVERIFY(!clusterer.update(m_all[0]));
+
+    setExposure(m_all[1], 195);
+    QVERIFY(clusterer.update(m_all[1]));
+    check(&clusterer);
+
+    setExposure(m_all[5], 110);
+    QVERIFY(clusterer.update(m_all[5]));
+    check(&clusterer);
+
+    setExposure(m_all[3], 20);
+    QVERIFY(clusterer.update(m_all[3]));
+    check(&clusterer);
+
+    MediaSource* outside = newMedia(50);
+    QVERIFY(!clusterer.update(outside));
+}
+
+void tst_SessionClusterer::set_gap()
+{
+    SessionClusterer clusterer(0);
+
+    qint64 times[] = { 0, 0, 3, 7, 15, 30, 31, 60, 100 };
+    for (unsigned i = 0; i < sizeof(times) / sizeof(times[0]); ++i) {
+        m_media.append(newMedia(times[i]));
+        clusterer.insert(m_media.last());
+    }
+    check(&clusterer);
+
+    qint64 gaps[] = { 3, 10, 40, 1, 29, 0, 1000 };
+    for (unsigned i = 0; i < sizeof(gaps) / sizeof(gaps[0]); ++i) {
+        clusterer.setGap(gaps[i]);
+        QCOMPARE(clusterer.gap(), gaps[i]);
+
+        // a new gap regroups everything, so the view starts again
+        m_view = clusterer.sessions();
+        check(&clusterer);
+        QVERIFY(clusterer.takeChanges().added.isEmpty());
+    }
+    QCOMPARE(clusterer.sessionCount(), 1);
+}
+
+void tst_SessionClusterer::unset_exposure()
+{
+    SessionClusterer clusterer(std::numeric_limits<qint64>::max());
+
+    MediaSource* unset = new MediaSource();
+    m_all.append(unset);
+    QCOMPARE(unset->exposureMSecs(), std::numeric_limits<qint64>::min());
+
+    MediaSource* late = newMedia(std::numeric_limits<qint64>::max() / 2);
+    clusterer.insert(late);
+    clusterer.insert(unset);
+    QCOMPARE(clusterer.sessionCount(), 2);
+
+    clusterer.setGap(1000);
+    QCOMPARE(clusterer.sessionCount(), 2);
+
+    MediaSource* early = newMedia(-std::numeric_limits<qint64>::max() / 2);
+    clusterer.insert(early);
+    QCOMPARE(clusterer.sessionCount(), 3);
+
+    clusterer.remove(early);
+    QCOMPARE(clusterer.sessionCount(), 2);
+
+    QList<Session> sessions = clusterer.sessions();
+    QCOMPARE(sessions.first().startMSecs, std::numeric_limits<qint64>::min());
+    QCOMPARE(sessions.first().count, 1);
+}
+
+void tst_SessionClusterer::random_operations()
+{
+    qsrand(37);
+
+    SessionClusterer clusterer(20);
+
+    for (int step = 0; step < 2000; ++step) {
+        int operation = qrand() % 10;
+
+        if (operation < 4 || m_media.isEmpty()) {
+            MediaSource* media = newMedia(qrand() % 2000);
+            clusterer.insert(media);
+            m_media.append(media);
+        } else if (operation < 7) {
+            MediaSource* media = m_media.takeAt(qrand() % m_media.count());
+            clusterer.remove(media);
+        } else if (operation < 9) {
+            MediaSource* media = m_media[qrand() % m_media.count()];
+            setExposure(media, qrand() % 2000);
+            clusterer.update(media);
+        } else {
+            // a new gap regroups everything, so the view starts again
+            qint64 gap = qrand() % 40;
+            if (gap != clusterer.gap()) {
+                clusterer.setGap(gap);
+                m_view = clusterer.sessions();
+            }
+        }
+
+        // batches of changes as well as single ones
+        if (qrand() % 3 == 0)
+            check(&clusterer);
+        if (QTest::currentTestFailed())
+            return;
+    }
+}
+
+QTEST_MAIN(tst_SessionClusterer);
+
+#include "tst_sessionclusterer.moc"
@@ -24,15 +24,48 @@
 #include "album.h"
 #include "album-default-template.h"
 
+#include <QDateTime>
+#include <QPair>
+
+// album id and media id of each row
+static QList<QPair<qint64, qint64> > albumMediaFakeTable;
+
+// for controlling the fake AlbumTable from the tests
+void addFakeAlbumMedia(qint64 albumId, qint64 mediaId)
+{
+    albumMediaFakeTable.append(qMakePair(albumId, mediaId));
+}
+
+int fakeAlbumMediaCount(qint64 albumId)
+{
+    int count = 0;
+    for (int i = 0; i < albumMediaFakeTable.count(); i++) {
+        if (albumMediaFakeTable[i].first == albumId)
+            count++;
+    }
+    return count;
+}
+
 AlbumTable::AlbumTable(Database* db, QObject* parent)
     : QObject(parent),
       m_db(db)
 {
+    albumMediaFakeTable.clear();
 }
 
-void AlbumTable::getAlbums(QList<Album*>* albumSet)
+void AlbumTable::getAlbums(QList<Album*>* albumSet,
+                           QHash<qint64, QList<qint64> >* albumMedia)
 {
-    Q_UNUSED(albumSet);
+    for (int i = 0; i < albumMediaFakeTable.count(); i++) {
+        qint64 albumId = albumMediaFakeTable[i].first;
+        if (!albumMedia->contains(albumId)) {
+            Album* a = new Album(this, "Album", "", albumId, QDateTime::currentDateTime(),
+                                 true, Album::FIRST_VALID_CURRENT_PAGE, "default");
+            a->setAlbumTable(this);
+            albumSet->append(a);
+        }
+        (*albumMedia)[albumId].append(albumMediaFakeTable[i].second);
+    }
 }
 
 void AlbumTable::addAlbum(Album* album)
@@ -53,8 +86,7 @@ void AlbumTable::attachToAlbum(qint64 albumId, qint64 mediaId)
 
 void AlbumTable::detachFromAlbum(qint64 albumId, qint64 mediaId)
 {
-    Q_UNUSED(albumId);
-    Q_UNUSED(mediaId);
+    albumMediaFakeTable.removeAll(qMakePair(albumId, mediaId));
 }
 
 void AlbumTable::mediaForAlbum(qint64 albumId, QList<qint64>* list) const
@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2014 Canonical Ltd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest/QtTest>
+#include <QList>
+
+#include "view-window.h"
+
+/*!
+ * Checks ViewWindow exhaustively over small collections against a list
+ * simulation: replaying the reported rows on the old window has to give the
+ * new one, and no element in both windows may have its row removed
+ */
+class tst_ViewWindow : public QObject
+{
+  Q_OBJECT
+
+private slots:
+    void range_removed();
+    void range_inserted();
+    void moved();
+};
+
+static const int MAX_COUNT = 12;
+
+static QList<int> elements(int count)
+{
+    QList<int> list;
+    for (int i = 0; i < count; ++i)
+        list.append(i);
+
+    return list;
+}
+
+static QList<int> window(const QList<int>& list, int head, int limit)
+{
+    return list.mid(head, limit);
+}
+
+// Replays the change on the old window's rows, with -1 for each added row
+static QList<int> replay(QList<int> rows, const ViewWindowChange& change)
+{
+    int last = -1;
+    bool first = true;
+    foreach (const DataIndexRange& range, change.removedRows) {
+        Q_ASSERT(first || range.second < last);
+        for (int row = range.second; row >= range.first; --row)
+            rows.removeAt(row);
+        last = range.first;
+        first = false;
+    }
+
+    foreach (const DataIndexRange& range, change.addedRows) {
+        for (int row = range.first; row <= range.second; ++row)
+            rows.insert(row, -1);
+    }
+
+    return rows;
+}
+
+static bool matches(const QList<int>& oldWindow, const QList<int>& newWindow,
+                    const ViewWindowChange& change)
+{
+    foreach (const DataIndexRange& range, change.removedRows) {
+        if (range.first > range.second || range.first < 0 || range.second >= oldWindow.count())
+            return false;
+    }
+
+    QList<int> rows = replay(oldWindow, change);
+    if (rows.count() != newWindow.count())
+        return false;
+
+    int added = 0;
+    for (int row = 0; row < rows.count(); ++row) {
+        if (rows[row] == -1) {
+            // only elements new to the window get new rows
+            if (oldWindow.contains(newWindow[row]))
+                return false;
+            ++added;
+        } else if (rows[row] != newWindow[row]) {
+            return false;
+        }
+    }
+
+    int joined = 0;
+    foreach (int element, newWindow)
+        joined += oldWindow.contains(element) ? 0 : 1;
+
+    return added == joined;
+}
+
+void tst_ViewWindow::range_removed()
+{
+    for (int count = 1; count <= MAX_COUNT; ++count) {
+        for (int head = 0; head <= count + 1; ++head) {
+            for (int limit = -1; limit <= count + 1; ++limit) {
+                for (int first = 0; first < count; ++first) {
+                    for (int last = first; last < count; ++last) {
+                        QList<int> list = elements(count);
+                        QList<int> old_window = window(list, head, limit);
+                        for (int index = last; index >= first; --index)
+                            list.removeAt(index);
+
+                        ViewWindowChange change =
+                            ViewWindow::rangeRemoved(count, head, limit, first, last);
+                        QVERIFY2(matches(old_window, window(list, head, limit), change),
+                                 qPrintable(QString("count %1 head %2 limit %3 removed %4-%5")
+                                            .arg(count).arg(head).arg(limit).arg(first).arg(last)));
+                    }
+                }
+            }
+        }
+    }
+}
+
+void tst_ViewWindow::range_inserted()
+{
+    for (int count = 0; count <= MAX_COUNT; ++count) {
+        for (int head = 0; head <= count + 1; ++head) {
+            for (int limit = -1; limit <= count + 1; ++limit) {
+                for (int first = 0; first <= count; ++first) {
+                    for (int inserted = 1; inserted <= 4; ++inserted) {
+                        int last = first + inserted - 1;
+
+                        QList<int> list = elements(count);
+                        QList<int> old_window = window(list, head, limit);
+                        for (int index = first; index <= last; ++index)
+                            list.insert(index, count + index);
+
+                        ViewWindowChange change =
+                            ViewWindow::rangeInserted(count, head, limit, first, last);
+                        QVERIFY2(matches(old_window, window(list, head, limit), change),
+                                 qPrintable(QString("count %1 head %2 limit %3 inserted %4-%5")
+                                            .arg(count).arg(head).arg(limit).arg(first).arg(last)));
+                    }
+                }
+            }
+        }
+    }
+}
+
+void tst_ViewWindow::moved()
+{
+    for (int count = 0; count <= MAX_COUNT; ++count) {
+        QList<int> list = elements(count);
+
+        for (int old_head = 0; old_head <= count + 1; ++old_head) {
+            for (int old_limit = -1; old_limit <= count + 1; ++old_limit) {
+                for (int head = 0; head <= count + 1; ++head) {
+                    for (int limit = -1; limit <= count + 1; ++limit) {
+                        ViewWindowChange change =
+                            ViewWindow::moved(count, old_head, old_limit, head, limit);
+                        QVERIFY2(matches(window(list, old_head, old_limit),
+                                         window(list, head, limit), change),
+                                 qPrintable(QString("count %1 from %2/%3 to %4/%5")
+                                            .arg(count).arg(old_head).arg(old_limit)
+                                            .arg(head).arg(limit)));
+                    }
+                }
+            }
+        }
+    }
+}
+
+QTEST_MAIN(tst_ViewWindow);
+
+#include "tst_view-window.moc"